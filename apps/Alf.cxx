@@ -29,6 +29,8 @@
 #include "ReadoutCard/ChannelFactory.h"
 #include "ReadoutCard/Exception.h"
 #include "ReadoutCard/FirmwareChecker.h"
+#include "ThreadPool.h"
+#include "Util.h"
 
 #include <Common/SimpleLog.h>
 extern SimpleLog alfDebugLog;
@@ -70,10 +72,68 @@ class Alf : public AliceO2::Common::Program
     options.add_options()("swt-word-size",
                           po::value<std::string>(&mOptions.swtWordSize)->default_value("low"),
                           "Sets the size of SWT word operations (low, medium, high)");
+    options.add_options()("workers",
+                          po::value<int>(&mOptions.workers)->default_value(0),
+                          "Number of worker threads running CARD_SEQUENCE link sections (0 for the number of hardware threads)");
+    options.add_options()("card-threads",
+                          po::value<int>(&mOptions.cardThreads)->default_value(0),
+                          "Number of DIM RPC threads per card, shared by the execution lanes of all its links (0 for one thread per link)");
+    options.add_options()("rpc-timeout",
+                          po::value<int>(&mOptions.rpcTimeout)->default_value(0),
+                          "Time in ms allowed to RPCs without a deadline directive, from the start of their handling (0 for unlimited)");
+    options.add_options()("link-failure-threshold",
+                          po::value<int>(&mOptions.linkFailureThreshold)->default_value(0),
+                          "Number of consecutive SCA and IC transaction timeouts marking a link down, failing fast until it responds again (0 to disable)");
+    options.add_options()("link-probe-interval",
+                          po::value<int>(&mOptions.linkProbeInterval)->default_value(10000),
+                          "Time in ms between the probes of a link marked down");
+    options.add_options()("timeout-factor",
+                          po::value<double>(&mOptions.timeoutFactor)->default_value(0),
+                          "Factor applied to the 99.9th percentile SC latencies observed on a link to derive its timeouts (0 for the default timeouts)");
+    options.add_options()("timeout-floor",
+                          po::value<int>(&mOptions.timeoutFloor)->default_value(1),
+                          "Minimum adaptive SC timeout in ms");
+    options.add_options()("timeout-ceiling",
+                          po::value<int>(&mOptions.timeoutCeiling)->default_value(100),
+                          "Maximum adaptive SC timeout in ms");
+    options.add_options()("sca-timeout",
+                          po::value<int>(&mOptions.scaTimeout)->default_value(0),
+                          "Pins the SCA busy wait timeout of all links in ms (0 for the default or adaptive timeout)");
+    options.add_options()("swt-timeout",
+                          po::value<int>(&mOptions.swtTimeout)->default_value(0),
+                          "Pins the SWT read timeout of all links in ms (0 for the default or adaptive timeout)");
+    options.add_options()("ic-timeout",
+                          po::value<int>(&mOptions.icTimeout)->default_value(0),
+                          "Pins the IC completion timeout of all links in ms (0 for the default or adaptive timeout)");
+    options.add_options()("client-rate",
+                          po::value<double>(&mOptions.clientRate)->default_value(0),
+                          "Requests per second allowed to each DIM client of weight 1, beyond which its requests are rejected (0 for unlimited)");
+    options.add_options()("client-burst",
+                          po::value<double>(&mOptions.clientBurst)->default_value(10),
+                          "Requests a DIM client of weight 1 may issue at once above its rate");
+    options.add_options()("client-weights",
+                          po::value<std::string>(&mOptions.clientWeights)->default_value(""),
+                          "Weights of the DIM clients whose name (pid@host) contains the given strings: string=weight,... (1 for the others)");
+    options.add_options()("link-locks",
+                          po::bool_switch(&mOptions.linkLocks)->default_value(false),
+                          "Locks the locked SCA, SWT and IC sequences of a link with a per-link lock inside ALF instead of the card's LLA session, except those resetting the SC cores. The per-link locks only exclude other ALF requests, not other LLA users of the card");
+    options.add_options()("register-before-start",
+                          po::bool_switch(&mOptions.registerBeforeStart)->default_value(false),
+                          "Makes all the DIM services before starting the DIM server, so that they are registered with the DIM DNS in one batch");
+    options.add_options()("link-mask",
+                          po::value<std::string>(&mOptions.linkMask)->default_value(""),
+                          "Links and SC cores whose services are made, for the cards listed: [serial][/endpoint]:[links]:[sca,swt,ic];... (all links for the others)");
+    options.add_options()("lla-lease",
+                          po::value<int>(&mOptions.llaLease)->default_value(0),
+                          "Idle window in ms for which the LLA session of a card stays leased to the client of a locked sequence (0 to stop it right away)");
+    options.add_options()("sequence-dir",
+                          po::value<std::string>(&mOptions.sequenceDir)->default_value(""),
+                          "Directory of stored sequences to load at startup, one per file named [name].[type]");
   }
 
   virtual void run(const po::variables_map&) override
   {
+    auto startupStart = std::chrono::steady_clock::now();
     kDebugLogging = isVerbose();
 
     Logger::setFacility("ALF");
@@ -140,55 +200,93 @@ class Alf : public AliceO2::Common::Program
     std::string alfId = ip::host_name();
     boost::to_upper(alfId);
 
-    Logger::get() << "Starting the DIM Server" << LogInfoDevel_(5004) << endm;
     DimServer::setDnsNode(mOptions.dimDnsNode.c_str(), 2505);
-    DimServer::start(("ALF_" + alfId).c_str());
+    if (!mOptions.registerBeforeStart) {
+      Logger::get() << "Starting the DIM Server" << LogInfoDevel_(5004) << endm;
+      DimServer::start(("ALF_" + alfId).c_str());
+    }
+
+    RequestDeadline::defaultTimeout = mOptions.rpcTimeout;
+    ScBase::setCircuitBreaker(mOptions.linkFailureThreshold, mOptions.linkProbeInterval);
+    ScBase::setAdaptiveTimeouts(mOptions.timeoutFactor, mOptions.timeoutFloor, mOptions.timeoutCeiling);
+    ScBase::pinTimeout(ScBase::ScaTimeout, mOptions.scaTimeout);
+    ScBase::pinTimeout(ScBase::SwtTimeout, mOptions.swtTimeout);
+    ScBase::pinTimeout(ScBase::IcTimeout, mOptions.icTimeout);
+
+    std::vector<std::pair<std::string, double>> clientWeights;
+    if (mOptions.clientWeights != "") {
+      for (const auto& clientWeight : Util::split(mOptions.clientWeights, ",")) {
+        auto pair = Util::split(clientWeight, "=");
+        try {
+          clientWeights.push_back({ pair.at(0), std::stod(pair.at(1)) });
+        } catch (const std::exception& e) {
+          Logger::get() << "Ignoring invalid client weight: " << clientWeight << LogWarningOps_(5015) << endm;
+        }
+      }
+    }
+    RequestClient::configure(mOptions.clientRate, mOptions.clientBurst, clientWeights);
+    LlaSession::setLease(std::chrono::milliseconds(mOptions.llaLease));
 
-    AlfServer alfServer = AlfServer(swtWordSize);
+    AlfServer alfServer = AlfServer(swtWordSize, mOptions.workers, mOptions.linkLocks);
+    alfServer.setLinkMask(AlfServer::parseLinkMask(mOptions.linkMask));
+
+    if (mOptions.sequenceDir != "") {
+      try {
+        alfServer.loadSequences(mOptions.sequenceDir);
+      } catch (const std::exception& e) {
+        Logger::get() << "Could not load stored sequences: " << e.what() << LogWarningOps_(5012) << endm;
+      }
+    }
 
     std::vector<roc::CardDescriptor> cardsFound = roc::findCards();
+
+    // Check the firmware and open the BARs of the cards in parallel, as they take most of the startup time
+    std::vector<std::future<CardInit>> cardInits;
+    ThreadPool initPool(std::max<size_t>(1, cardsFound.size()));
     for (auto const& card : cardsFound) {
-      std::vector<AlfLink> links;
+      cardInits.push_back(initPool.submit([this, card, alfId]() { return initCard(card, alfId); }));
+    }
 
-      std::shared_ptr<roc::BarInterface> bar;
+    // Make the RPC services for every card & link, in the order the cards were found
+    for (size_t i = 0; i < cardsFound.size(); i++) {
+      auto const& card = cardsFound[i];
+      CardInit cardInit = cardInits[i].get();
 
-      // Make the RPC services for every card & link
-      if (!mOptions.noFirmwareCheck) {
-        try {
-          roc::FirmwareChecker().checkFirmwareCompatibility(card.pciAddress);
-        } catch (const roc::Exception& e) {
-          Logger::get() << e.what() << LogWarningOps_(5005) << endm;
-          continue;
-        }
+      if (cardInit.firmwareError != "") {
+        Logger::get() << cardInit.firmwareError << LogWarningOps_(5005) << endm;
+        continue;
       }
 
       if (card.cardType == roc::CardType::Cru) {
-
         Logger::get() << "CRU " << card.serialId << " registered" << LogInfoDevel_(5006) << endm;
-        bar = roc::ChannelFactory().getBar(card.serialId, 2);
-        for (int linkId = 0; linkId < kCruNumLinks; linkId++) {
-          links.push_back({ alfId, card.serialId, linkId, card.serialId.getEndpoint() * 12 + linkId, bar, roc::CardType::Cru });
-        }
-
       } else if (card.cardType == roc::CardType::Crorc) {
         Logger::get() << "CRORC " << card.serialId << " registered" << LogInfoDevel_(5007) << endm;
-        for (int linkId = 0; linkId < kCrorcNumLinks; linkId++) {
-          bar = roc::ChannelFactory().getBar(card.serialId, linkId);
-          links.push_back({ alfId, card.serialId, linkId, -1, bar, roc::CardType::Crorc });
-        }
       } else {
         Logger::get() << card.serialId << " is not a CRU or a CRORC. Skipping..." << LogWarningDevel_(5008) << endm;
       }
 
       if (isVerbose()) {
-        for (auto const& link : links) {
+        for (auto const& link : cardInit.links) {
           Logger::get() << link.alfId << " " << link.serialId << " " << link.linkId << LogDebugDevel_(5009) << endm;
         }
       }
-      alfServer.makeRpcServers(links, mOptions.sequentialRpcs);
+
+      auto start = std::chrono::steady_clock::now();
+      alfServer.makeRpcServers(cardInit.links, mOptions.sequentialRpcs, mOptions.cardThreads);
+      auto services = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+      Logger::get() << card.serialId << " initialized: discovery " << cardInit.duration.count() << " ms, services "
+                    << services.count() << " ms" << LogInfoDevel_(5016) << endm;
+    }
+
+    if (mOptions.registerBeforeStart) {
+      // All the services are registered with the DIM DNS at once
+      Logger::get() << "Starting the DIM Server" << LogInfoDevel_(5004) << endm;
+      DimServer::start(("ALF_" + alfId).c_str());
     }
 
-    alfDebugLog.info("Ready on DIM DNS %s with ALF id %s", mOptions.dimDnsNode.c_str(), alfId.c_str());
+    auto startup = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startupStart);
+    Logger::get() << "Ready in " << startup.count() << " ms" << LogInfoDevel_(5017) << endm;
+    alfDebugLog.info("Ready on DIM DNS %s with ALF id %s in %lld ms", mOptions.dimDnsNode.c_str(), alfId.c_str(), (long long)startup.count());
 
     // main thread
     while (!isSigInt()) {
@@ -197,12 +295,71 @@ class Alf : public AliceO2::Common::Program
   }
 
  private:
+  /// Links of a card, once its firmware checked and its BARs opened
+  struct CardInit {
+    std::vector<AlfLink> links;
+    std::string firmwareError; // the card is skipped if its firmware check failed
+    std::chrono::milliseconds duration;
+  };
+
+  /// Checks the firmware of a card and opens its BARs
+  CardInit initCard(const roc::CardDescriptor& card, const std::string& alfId)
+  {
+    CardInit cardInit;
+    auto start = std::chrono::steady_clock::now();
+
+    if (!mOptions.noFirmwareCheck) {
+      try {
+        roc::FirmwareChecker().checkFirmwareCompatibility(card.pciAddress);
+      } catch (const roc::Exception& e) {
+        cardInit.firmwareError = e.what();
+      }
+    }
+
+    if (cardInit.firmwareError == "") {
+      std::shared_ptr<roc::BarInterface> bar;
+      if (card.cardType == roc::CardType::Cru) {
+        bar = roc::ChannelFactory().getBar(card.serialId, 2);
+        for (int linkId = 0; linkId < kCruNumLinks; linkId++) {
+          cardInit.links.push_back({ alfId, card.serialId, linkId, card.serialId.getEndpoint() * 12 + linkId, bar, roc::CardType::Cru });
+        }
+      } else if (card.cardType == roc::CardType::Crorc) {
+        for (int linkId = 0; linkId < kCrorcNumLinks; linkId++) {
+          bar = roc::ChannelFactory().getBar(card.serialId, linkId);
+          cardInit.links.push_back({ alfId, card.serialId, linkId, -1, bar, roc::CardType::Crorc });
+        }
+      }
+    }
+
+    cardInit.duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    return cardInit;
+  }
+
   struct OptionsStruct {
     std::string dimDnsNode = "";
     bool noFirmwareCheck = false;
     bool sequentialRpcs = false;
     std::string swtWordSize = "low";
     std::string dimLogFileConfig = "";
+    std::string sequenceDir = "";
+    int workers = 0;
+    int cardThreads = 0;
+    int rpcTimeout = 0;
+    int linkFailureThreshold = 0;
+    int linkProbeInterval = 10000;
+    double timeoutFactor = 0;
+    int timeoutFloor = 1;
+    int timeoutCeiling = 100;
+    int scaTimeout = 0;
+    int swtTimeout = 0;
+    int icTimeout = 0;
+    double clientRate = 0;
+    double clientBurst = 10;
+    std::string clientWeights = "";
+    int llaLease = 0;
+    bool linkLocks = false;
+    bool registerBeforeStart = false;
+    std::string linkMask = "";
   } mOptions;
 };
 
@@ -54,10 +54,21 @@ class Ic : public ScBase
     uint32_t data = 0x0;
   };
 
+  /// Struct holding the arguments and the outcome of an IC poll
+  struct PollData {
+    uint32_t address = 0x0;
+    uint32_t mask = 0x0;
+    uint32_t expected = 0x0;
+    int interval = 0; // ms
+    int timeout = 0;  // ms
+    uint32_t value = 0x0; // last value read, set on completion
+    int elapsed = 0;      // ms, set on completion
+  };
+
   typedef uint32_t IcOut;
   /// Typedef for the Data type of an IC sequence operation.
-  /// Variant of IcData for writes, IcOut for reads, std::string for errors;
-  typedef boost::variant<IcData, IcOut, std::string> Data;
+  /// Variant of IcData for writes, IcOut for reads, std::string for errors, PollData for polls;
+  typedef boost::variant<IcData, IcOut, std::string, PollData> Data;
 
   /// Internal constructor for the ALF server
   /// \param link AlfLink holding useful information coming from the AlfServer class
@@ -100,6 +111,12 @@ class Ic : public ScBase
     return write(icData.address, icData.data);
   }
 
+  /// Repeats an IC read until the masked value matches the expected value
+  /// \param pollData Address, mask, expected value, interval and timeout
+  /// \return The PollData with the last value read and the time elapsed
+  /// \throws o2::alf::IcException on timeout
+  PollData poll(PollData pollData);
+
   /// Performs a GBT I2C write
   /// \param data Data to write
   void writeGbtI2c(uint32_t data);
@@ -108,7 +125,8 @@ class Ic : public ScBase
   enum Operation { Read,
                    Write,
                    Error,
-                   Lock };
+                   Lock,
+                   Poll };
 
   /// Executes an IC sequence
   /// \param ops A vector of Data and Operations pairs
@@ -125,8 +143,26 @@ class Ic : public ScBase
   ///         o2::lla::LlaException on lock fail
   std::string writeSequence(std::vector<std::pair<Operation, Data>> ops, bool lock = false);
 
+  /// Formats the output of a sequence as returned by writeSequence
+  /// \param out A vector of Data and Operation pairs, as returned by executeSequence
+  /// \return A string of newline separated results;
+  /// \throws o2::alf::IcException on error
+  static std::string formatSequenceOutput(const std::vector<std::pair<Operation, Data>>& out);
+
   static std::string IcOperationToString(Operation op);
   static Ic::Operation StringToIcOperation(std::string op);
+
+ private:
+  /// Waits for the IC FIFO to report the completion of a transaction, up to the link's IC timeout
+  /// \return True if the transaction completed in time
+  bool waitOnCompletion();
+
+  /// Pops the replies left in the IC FIFO, so that the completion of the next transaction is not mistaken for a
+  /// stale reply
+  void drainFifo();
+
+  /// Maximum number of replies popped by drainFifo()
+  static constexpr int kMaxFifoDrain = 64;
 };
 
 } // namespace alf
@@ -18,6 +18,12 @@
 #ifndef O2_ALF_INC_LLA_H_
 #define O2_ALF_INC_LLA_H_
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+
 #include "Lla/Lla.h"
 
 namespace lla = o2::lla;
@@ -27,20 +33,64 @@ namespace o2
 namespace alf
 {
 
+/// Server-wide statistics of the LLA session leases
+struct LlaLeaseStatistics {
+  inline static std::atomic<uint64_t> reused{ 0 };    ///< Lock acquisitions avoided by reusing a lease
+  inline static std::atomic<uint64_t> preempted{ 0 }; ///< Leases released early for another client
+  inline static std::atomic<uint64_t> expired{ 0 };   ///< Leases released after their idle window
+};
+
+/// Contention of the LLA lock of a card, as taken through ALF
+struct LlaLockStatistics {
+  /// Wait and hold time buckets, by decade: < 10 us, < 100 us, ..., < 1 s, >= 1 s
+  static constexpr int kNumBuckets = 7;
+  std::array<uint64_t, kNumBuckets> wait = {};
+  std::array<uint64_t, kNumBuckets> hold = {};
+  uint64_t acquisitions = 0;
+  uint64_t failures = 0;
+  std::string holder; ///< Client holding the lock through ALF, empty if none
+  std::chrono::steady_clock::time_point heldSince;
+};
+
 class LlaSession
 {
  public:
-  LlaSession(std::shared_ptr<lla::Session> llaSession);
+  LlaSession(std::shared_ptr<lla::Session> llaSession, roc::SerialId serialId = -1);
   LlaSession(std::string sessionName, roc::SerialId serialId);
   ~LlaSession();
-  void start(int timeout=0);
-  void stop();
+  /// Starts the session, unless already started
+  /// \param timeout timeout (in ms) for aquiring the lock, 0 to block
+  /// \return true if the session was started by this call, false if it was already started
+  /// \throws o2::lla::LlaException on lock fail
+  bool start(int timeout=0);
+  /// Stops the session, or leases it to the current client if it was started by this object and leases are enabled
+  /// \param lease Whether the session may be leased, only after locked sequences: other users (e.g. read-modify-writes)
+  ///        release it right away
+  void stop(bool lease = false);
+
+  /// Enables leases: a session stopped after a locked sequence stays started for the given idle window, so that the
+  /// next locked sequence of the same client reuses it instead of acquiring the card lock again. The lease is
+  /// released when the window elapses, or as soon as another client needs the session.
+  /// \param idleWindow The idle window, 0 to disable leases
+  static void setLease(std::chrono::milliseconds idleWindow);
+
+  /// Leaves the session started when this object is destroyed, for sessions held across requests
+  void detach();
+
+  /// \return The contention statistics of the LLA lock of a card
+  static LlaLockStatistics getLockStatistics(int serial);
+
+  /// Sets the callback invoked with the serial of a card when its LLA lock is taken, released or not acquired
+  static void setLockCallback(std::function<void(int)> callback);
 
  private:
   lla::SessionParameters mParams;
   std::shared_ptr<lla::Session> mSession;
   std::string mSessionName;
   roc::SerialId mSerialId = -1;
+  /// Whether the session was started (or its lease taken) by this object
+  bool mHeld = false;
+  bool mDetached = false;
 };
 
 } // namespace alf
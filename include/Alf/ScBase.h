@@ -18,6 +18,9 @@
 #ifndef O2_ALF_INC_SCBASE_H
 #define O2_ALF_INC_SCBASE_H
 
+#include <chrono>
+#include <functional>
+
 #include "ReadoutCard/BarInterface.h"
 #include "ReadoutCard/Parameters.h"
 
@@ -35,6 +38,14 @@ namespace alf
 class ScBase
 {
  public:
+  /// Kinds of SC transactions with a per-link timeout
+  enum TimeoutKind {
+    ScaTimeout, ///< Busy and channel busy waits of an SCA transaction
+    SwtTimeout, ///< Wait for the SWT READ FIFO to fill, unless the sequence sets its own read timeout
+    IcTimeout,  ///< Wait for the completion of an IC transaction
+    NumTimeoutKinds
+  };
+
   /// Internal constructor for the AlfServer
   /// \param link AlfLink holding useful information coming from the AlfServer class
   ScBase(AlfLink link, std::shared_ptr<lla::Session> llaSession);
@@ -60,7 +71,66 @@ class ScBase
   /// \throws o2::alf::ScException if no SC channel selected
   void checkChannelSet();
 
+  /// Fails fast if the link has been marked down by the circuit breaker, unless a probe is due
+  /// \throws o2::alf::ScException if the link is down
+  void checkLinkUp();
+
+  /// Configures the per-link circuit breaker: after a number of consecutive timeouts a link is marked down, and its
+  /// sequences fail fast until a probe, let through every probeInterval, succeeds
+  /// \param threshold Number of consecutive timeouts marking a link down, 0 to disable the circuit breaker
+  /// \param probeInterval Time between probes of a link marked down in ms
+  static void setCircuitBreaker(int threshold, int probeInterval);
+
+  /// Sets a callback run when a link is marked down, or back up
+  /// \param callback The callback to run, with the link and whether it is down
+  static void setLinkStateCallback(std::function<void(const AlfLink&, bool)> callback);
+
+  /// Configures the adaptive timeouts: once enough latencies of a kind of transaction have been observed on a link,
+  /// its timeout becomes their 99.9th percentile times a factor, clamped between a floor and a ceiling
+  /// \param factor Factor applied to the 99.9th percentile latency, 0 to keep the default timeouts
+  /// \param floor Minimum adaptive timeout in ms
+  /// \param ceiling Maximum adaptive timeout in ms
+  static void setAdaptiveTimeouts(double factor, int floor, int ceiling);
+
+  /// Pins the timeout of a kind of transaction on all links, overriding the default and adaptive timeouts
+  /// \param kind The kind of transaction
+  /// \param timeout The timeout in ms, 0 to unpin it
+  static void pinTimeout(TimeoutKind kind, int timeout);
+
+  /// Gets the timeout currently applied to a kind of transaction on a link
+  /// \param link The link
+  /// \param kind The kind of transaction
+  /// \return The timeout
+  static std::chrono::microseconds getTimeout(const AlfLink& link, TimeoutKind kind);
+
+  /// Gets a quantile of the latencies observed for a kind of transaction on a link
+  /// \param link The link
+  /// \param kind The kind of transaction
+  /// \param quantile The quantile, the 99.9th percentile by default
+  /// \return The latency, or 0 if too few transactions have been observed
+  static std::chrono::microseconds getLatencyQuantile(const AlfLink& link, TimeoutKind kind, double quantile = 0.999);
+
+  /// Sets a callback run before every operation of a sequence, e.g. to check the deadline of the request, or to let
+  /// more urgent requests run in between the operations of sequences executed without the lock
+  /// \param callback The callback to run
+  void setOperationCallback(std::function<void()> callback);
+
  protected:
+  /// Runs the operation callback, if one is set
+  void runOperationCallback();
+
+  /// Counts a timeout of the link towards the circuit breaker
+  void recordLinkTimeout();
+
+  /// Resets the circuit breaker of the link after a successful transaction
+  void recordLinkSuccess();
+
+  /// \return The timeout currently applied to a kind of transaction on the link
+  std::chrono::microseconds getTimeout(TimeoutKind kind);
+
+  /// Records the latency of a transaction on the link, or the time waited until its timeout
+  void recordLatency(TimeoutKind kind, std::chrono::steady_clock::duration latency);
+
   uint32_t barRead(uint32_t index);
   void barWrite(uint32_t index, uint32_t data);
 
@@ -73,6 +143,9 @@ class ScBase
 
   /// Interface for BAR 2
   std::shared_ptr<roc::BarInterface> mBar2;
+
+  /// Callback run between the operations of unlocked sequences
+  std::function<void()> mOperationCallback;
 };
 
 } // namespace alf
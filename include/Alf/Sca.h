@@ -47,10 +47,30 @@ class Sca : public ScBase
     uint32_t data;
   };
 
+  /// Struct holding the arguments of an SCA read-modify-write
+  struct RmwData {
+    uint32_t readCommand;
+    uint32_t writeCommand;
+    uint32_t mask;
+    uint32_t data;
+  };
+
+  /// Struct holding the arguments and the outcome of an SCA poll
+  struct PollData {
+    CommandData commandData;
+    uint32_t mask;
+    uint32_t expected;
+    int interval; // ms
+    int timeout;  // ms
+    CommandData reply = { 0x0, 0x0 }; // last reply, set on completion
+    int elapsed = 0;                  // ms, set on completion
+  };
+
   typedef int WaitTime;
   /// Typedef for the Data type of an SCA sequence operation.
-  /// Variant of CommandData for writes, WaitTime for waits, std::string for errors;
-  typedef boost::variant<CommandData, WaitTime, std::string> Data;
+  /// Variant of CommandData for writes, WaitTime for waits, std::string for errors, RmwData for read-modify-writes,
+  /// PollData for polls;
+  typedef boost::variant<CommandData, WaitTime, std::string, RmwData, PollData> Data;
 
   /// Enum for the different SCA operation types as seen from DIM RPCs
   enum Operation { Command,
@@ -61,7 +81,9 @@ class Sca : public ScBase
                    Error,
                    Lock,
                    Master,
-                   Slave };
+                   Slave,
+                   ReadModifyWrite,
+                   Poll };
 
   /// Internal constructor for the AlfServer
   /// \param link AlfLink holding useful information coming from the AlfServer class
@@ -102,6 +124,21 @@ class Sca : public ScBase
   ///          o2::alf::ScaException on SCA error
   CommandData executeCommand(uint32_t command, uint32_t data, bool lock = false, int lockTimeout = 0);
 
+  /// Executes an SCA read-modify-write atomically
+  /// Reads through the read command, replaces the masked bits with the data, and writes back through the write command
+  /// \param rmwData SCA read command, write command, mask and data
+  /// \param lockTimeout timeout (in ms) for aquiring the lock, if not already held
+  /// \return The SCA command, data pair of the write
+  /// \throws  o2::lla::LlaException on lock fail
+  ///          o2::alf::ScaException on SCA error
+  CommandData readModifyWrite(RmwData rmwData, int lockTimeout = 0);
+
+  /// Repeats an SCA command until the masked data of its reply matches the expected value
+  /// \param pollData SCA command, data pair, mask, expected value, interval and timeout
+  /// \return The PollData with the last reply and the time elapsed
+  /// \throws o2::alf::ScaException on SCA error or timeout
+  PollData poll(PollData pollData);
+
   /// Executes an SCA sequence
   /// \param operations A vector of Operation and Data pairs
   /// \param lock Boolean enabling implicit locking
@@ -120,6 +157,12 @@ class Sca : public ScBase
   ///         o2::alf::ScaException on invalid operation or error
   std::string writeSequence(const std::vector<std::pair<Operation, Data>>& operations, bool lock = false, int lockTimeout = 0);
 
+  /// Formats the output of a sequence as returned by writeSequence
+  /// \param out A vector of Data and Operation pairs, as returned by executeSequence
+  /// \return A string of newline separated results;
+  /// \throws o2::alf::ScaException on error
+  static std::string formatSequenceOutput(const std::vector<std::pair<Operation, Data>>& out);
+
   static std::string ScaOperationToString(Operation op);
   static Sca::Operation StringToScaOperation(std::string op);
 
@@ -151,6 +194,8 @@ class Sca : public ScBase
 };
 
 std::ostream& operator<<(std::ostream& output, const Sca::CommandData& commandData);
+std::ostream& operator<<(std::ostream& output, const Sca::RmwData& rmwData);
+std::ostream& operator<<(std::ostream& output, const Sca::PollData& pollData);
 
 } // namespace alf
 } // namespace o2
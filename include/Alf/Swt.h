@@ -28,6 +28,7 @@
 #ifndef O2_ALF_INC_SWT_H
 #define O2_ALF_INC_SWT_H
 
+#include <atomic>
 #include <string>
 #include <boost/blank.hpp>
 #include <boost/variant.hpp>
@@ -47,15 +48,32 @@ namespace o2
 namespace alf
 {
 
+/// Server-wide statistics of the SWT write cache
+struct SwtWriteCacheStatistics {
+  inline static std::atomic<uint64_t> skippedWrites{ 0 }; ///< SWT_WR_WORD_H/M BAR writes avoided
+};
+
 /// Class for Single Word Transactions with the CRU
 class Swt : public ScBase
 {
  public:
   typedef int TimeOut, WaitTime;
 
+  /// Struct holding the arguments and the outcome of an SWT poll
+  struct PollData {
+    SwtWord word;     // word written before every read
+    SwtWord mask;     // bits of the reply to compare
+    SwtWord expected; // expected value of the masked bits
+    int interval = 0; // ms
+    int timeout = 0;  // ms
+    SwtWord reply;    // last word read, set on completion
+    int elapsed = 0;  // ms, set on completion
+  };
+
   /// Typedef for the Data type of an SWT sequence operation.
-  /// Variant of TimeOut for reads, SwtWord for writes, std::string for Errors
-  typedef boost::variant<boost::blank, TimeOut, WaitTime, SwtWord, std::string> Data;
+  /// Variant of TimeOut for reads, SwtWord for writes, std::string for Errors, SwtWord::Size for word size changes,
+  /// PollData for polls
+  typedef boost::variant<boost::blank, TimeOut, WaitTime, SwtWord, std::string, SwtWord::Size, PollData> Data;
 
   /// Enum for the different SWT operation types
   enum Operation { Read,
@@ -65,7 +83,9 @@ class Swt : public ScBase
                    SCReset,
                    Wait,
                    Error,
-                   Lock };
+                   Lock,
+                   WordSize,
+                   Poll };
 
   /// Internal constructor for the ALF server
   /// \param link AlfLink holding useful information coming from the AlfServer class
@@ -81,10 +101,22 @@ class Swt : public ScBase
   /// \param linkId The link ID to set the channel to (optional).
   Swt(std::string cardId, int linkId = -1);
 
+  /// Executes a global SC reset and invalidates the cached SWT write registers
+  void scReset();
+
   /// Writes an SWT word
+  /// SWT_WR_WORD_H and SWT_WR_WORD_M are only written if they differ from the last values written on the link
   /// \param swtWord The SWT word to write
   void write(const SwtWord& swtWord);
 
+  /// Invalidates the cached SWT_WR_WORD_H/M values, forcing the next write to set them
+  /// Should be called if the SWT registers of the link may have been accessed by another user
+  void invalidateWriteCache();
+
+  /// Gets the number of SWT_WR_WORD_H/M BAR writes avoided thanks to the cached values
+  /// \return The number of BAR writes skipped
+  uint64_t getSkippedWrites() const;
+
   /// Reads SWT words
   /// \param wordSize The size of the SWT words to be read
   /// \param msTimeOut Timeout of the read operation in ms
@@ -100,6 +132,12 @@ class Swt : public ScBase
   /// \throws o2::alf::SwtException in case of no SWT words in FIFO, or timeout exceeded
   std::vector<SwtWord> readMultiple(SwtWord::Size wordSize = SwtWord::Size::Low, unsigned int numberOfWords = 1, TimeOut msTimeOut = DEFAULT_SWT_TIMEOUT_MS);
 
+  /// Repeats an SWT write and read until the masked reply matches the expected word
+  /// \param pollData Word to write, mask, expected word, interval and timeout
+  /// \return The PollData with the last word read and the time elapsed
+  /// \throws o2::alf::SwtException on read error or timeout
+  PollData poll(PollData pollData);
+
   /// Executes an SWT sequence
   /// \param sequence A vector of Operation and Data pairs
   /// \param lock Boolean enabling implicit locking
@@ -108,6 +146,8 @@ class Swt : public ScBase
   ///         Write -> Echoes written data
   ///         Read  -> The SwtWord read
   ///         Reset -> Empty Data
+  ///         WordSize -> The SwtWord::Size used for subsequent reads
+  ///         Poll  -> The PollData with the last word read and the time elapsed
   ///         Error -> Error message in std::string
   /// \throws o2:lla::LlaException on lock fail
   std::vector<std::pair<Operation, Data>> executeSequence(std::vector<std::pair<Operation, Data>> sequence, bool lock = false, int lockTimeout = 0);
@@ -121,6 +161,12 @@ class Swt : public ScBase
   ///         o2::alf::SwtException on invalid operation or error
   std::string writeSequence(std::vector<std::pair<Operation, Data>> sequence, bool lock = false, int lockTimeout = 0);
 
+  /// Formats the output of a sequence as returned by writeSequence
+  /// \param out A vector of Data and Operation pairs, as returned by executeSequence
+  /// \return A string of newline separated results;
+  /// \throws o2::alf::SwtException on error
+  static std::string formatSequenceOutput(const std::vector<std::pair<Operation, Data>>& out);
+
   static std::string SwtOperationToString(Operation op);
   static Operation StringToSwtOperation(std::string op);
 
@@ -128,10 +174,25 @@ class Swt : public ScBase
   static constexpr int DEFAULT_SWT_WAIT_TIME_MS = 3;
 
  private:
+  /// \return The read timeout set by the sequence, or else the link's SWT timeout, in ms
+  TimeOut getReadTimeout();
+
   SwtWord::Size mSwtWordSize = SwtWord::Size::Low;
   TimeOut readTimeout = DEFAULT_SWT_TIMEOUT_MS;
+  /// Whether the sequence has set its own read timeout, otherwise the link's SWT timeout applies
+  bool readTimeoutSet = false;
+
+  /// Last values written to SWT_WR_WORD_H/M, valid only for mWriteCacheLinkId
+  int mWriteCacheLinkId = -1;
+  bool mLastHighValid = false;
+  bool mLastMedValid = false;
+  uint16_t mLastHigh = 0x0;
+  uint32_t mLastMed = 0x0;
+  uint64_t mSkippedWrites = 0;
 };
 
+std::ostream& operator<<(std::ostream& output, const Swt::PollData& pollData);
+
 } // namespace alf
 } // namespace o2
 
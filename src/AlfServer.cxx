@@ -17,6 +17,8 @@
 /// \author Kostas Alexopoulos (kostas.alexopoulos@cern.ch)
 
 #include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <iomanip>
 #include <thread>
 
@@ -33,104 +35,1049 @@ namespace o2
 namespace alf
 {
 
-AlfServer::AlfServer(SwtWord::Size swtWordSize) : mRpcServers(), mSwtWordSize(swtWordSize)
+namespace
 {
+/// Strips the directives leading a sequence
+/// \param lines The lines of the sequence
+/// \param optimize Set if the sequence should go through the optimizer
+/// \param dryRun Set if the duration of the sequence should be estimated instead of executing it
+void takeDirectives(std::vector<std::string>& lines, bool& optimize, bool& dryRun)
+{
+  optimize = false;
+  dryRun = false;
+  while (!lines.empty()) {
+    auto directive = boost::trim_copy(lines[0]);
+    if (directive == "optimize") {
+      optimize = true;
+    } else if (directive == "dry_run") {
+      dryRun = true;
+    } else {
+      break;
+    }
+    lines.erase(lines.begin());
+  }
+  if (lines.empty()) {
+    BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("Sequence has no operations"));
+  }
+}
+
+/// Merges adjacent waits, and drops resets and connects right after an identical one
+bool foldScaOp(std::pair<Sca::Operation, Sca::Data>& previous, const std::pair<Sca::Operation, Sca::Data>& op)
+{
+  if (previous.first != op.first) {
+    return false;
+  }
+  if (op.first == Sca::Operation::Wait) {
+    auto previousWait = boost::get<Sca::WaitTime>(&previous.second);
+    auto wait = boost::get<Sca::WaitTime>(&op.second);
+    if (!previousWait || !wait) {
+      return false;
+    }
+    previous.second = *previousWait + *wait;
+    return true;
+  }
+  return op.first == Sca::Operation::SCReset || op.first == Sca::Operation::SVLReset || op.first == Sca::Operation::SVLConnect;
+}
+
+/// Merges adjacent waits, and drops resets right after another one
+bool foldSwtOp(std::pair<Swt::Operation, Swt::Data>& previous, const std::pair<Swt::Operation, Swt::Data>& op)
+{
+  if (previous.first != op.first) {
+    return false;
+  }
+  if (op.first == Swt::Operation::Wait) {
+    auto previousWait = boost::get<Swt::WaitTime>(&previous.second);
+    auto wait = boost::get<Swt::WaitTime>(&op.second);
+    if (!previousWait || !wait) {
+      return false;
+    }
+    previous.second = *previousWait + *wait;
+    return true;
+  }
+  return op.first == Swt::Operation::SCReset;
+}
+
+/// Drops writes identical to the write right before them
+bool foldIcOp(std::pair<Ic::Operation, Ic::Data>& previous, const std::pair<Ic::Operation, Ic::Data>& op)
+{
+  if (previous.first != Ic::Operation::Write || op.first != Ic::Operation::Write) {
+    return false;
+  }
+  auto previousWrite = boost::get<Ic::IcData>(&previous.second);
+  auto write = boost::get<Ic::IcData>(&op.second);
+  return previousWrite && write && previousWrite->address == write->address && previousWrite->data == write->data;
+}
+} // namespace
+
+AlfServer::AlfServer(SwtWord::Size swtWordSize, int workers, bool linkLocks) : mRpcServers(), mSwtWordSize(swtWordSize), mLinkLocks(linkLocks)
+{
+  if (workers <= 0) {
+    workers = std::max(2u, std::thread::hardware_concurrency());
+  }
+  mWorkerPool = std::make_unique<ThreadPool>(workers);
+
+  // Publish the contention of the cards' LLA locks
+  LlaSession::setLockCallback([this](int serial) {
+    std::lock_guard<std::mutex> lock(mLockStatusMutex);
+    auto it = mLockStatus.find(serial);
+    if (it != mLockStatus.end()) {
+      it->second.status = toCharBuffer(lockStatus(serial));
+      it->second.service->updateService(it->second.status.data());
+    }
+  });
+
+  // Publish the state of the links' circuit breakers
+  ScBase::setLinkStateCallback([this](const AlfLink& link, bool down) {
+    std::shared_ptr<LinkContext> linkContext;
+    {
+      std::lock_guard<std::mutex> lock(mLinkContextsMutex);
+      auto& cardContexts = mLinkContexts[link.serialId.getSerial()];
+      auto it = cardContexts.find(link.rawLinkId);
+      if (it == cardContexts.end()) {
+        return;
+      }
+      linkContext = it->second;
+    }
+    linkContext->linkDown = down ? 1 : 0;
+    if (linkContext->linkStatusService) {
+      linkContext->linkStatusService->updateService();
+    }
+  });
+}
+
+AlfServer::~AlfServer()
+{
+  LlaSession::setLockCallback(nullptr);
 }
 
-std::string AlfServer::registerBlobWrite(const std::string& parameter, std::shared_ptr<roc::BarInterface> bar, bool isCru)
+std::string AlfServer::registerBlobWrite(const std::string& parameter, std::shared_ptr<roc::BarInterface> bar, bool isCru, std::shared_ptr<lla::Session> llaSession)
 {
   std::vector<std::string> stringPairs = Util::split(parameter, argumentSeparator());
-  std::vector<std::vector<uint32_t>> registerPairs = parseStringToRegisterPairs(stringPairs);
+  bool optimize, dryRun;
+  takeDirectives(stringPairs, optimize, dryRun);
+  auto registerPairs = parseStringToRegisterPairs(stringPairs);
+  if (dryRun) {
+    return CostModel::format(estimateRegisterSequence(registerPairs));
+  }
+  if (!optimize) {
+    return executeRegisterSequence(registerPairs, bar, isCru, llaSession);
+  }
+
+  // Drop writes identical to the write right before them
+  SequenceOptimizer<RegisterOperation, std::vector<uint32_t>> optimizer(
+    registerPairs,
+    [](RegisterPair& previous, const RegisterPair& registerPair) {
+      return previous.first == RegisterOperation::Write && registerPair == previous;
+    },
+    [](const RegisterPair&) { return CostModel::kBarAccess; });
+  return optimizer.restoreLines(executeRegisterSequence(optimizer.sequence(), bar, isCru, llaSession));
+}
+
+CostModel::Breakdown AlfServer::estimateRegisterSequence(const std::vector<RegisterPair>& registerPairs)
+{
+  static const std::map<RegisterOperation, std::string> names = {
+    { RegisterOperation::Read, "read" },
+    { RegisterOperation::Write, "write" },
+    { RegisterOperation::ReadBlock, "read_block" },
+    { RegisterOperation::WriteBlock, "write_block" },
+    { RegisterOperation::ReadModifyWrite, "rmw" },
+    { RegisterOperation::Poll, "poll" }
+  };
+
+  CostModel::Breakdown breakdown;
+  for (const auto& registerPair : registerPairs) {
+    const auto& args = registerPair.second;
+    uint64_t accesses = 1; // at least one read for polls
+    if (registerPair.first == RegisterOperation::ReadBlock) {
+      accesses = args.at(1);
+    } else if (registerPair.first == RegisterOperation::WriteBlock) {
+      accesses = args.size() - 1;
+    } else if (registerPair.first == RegisterOperation::ReadModifyWrite) {
+      accesses = 2;
+    }
+    auto& entry = breakdown[names.at(registerPair.first)];
+    entry.first++;
+    entry.second += accesses * CostModel::kBarAccess;
+  }
+  return breakdown;
+}
+
+std::string AlfServer::executeRegisterSequence(const std::vector<RegisterPair>& registerPairs, std::shared_ptr<roc::BarInterface> bar, bool isCru, std::shared_ptr<lla::Session> llaSession)
+{
   std::stringstream resultBuffer;
   uint32_t value;
   uint32_t address;
   for (const auto& registerPair : registerPairs) {
-    address = registerPair.at(0);
-    // If it's a CRU, check address range
-    if (isCru && (address < 0x00c00000 || address > 0x00cfffff)) {
-      resultBuffer << "Illegal address 0x" << std::hex << address
-                   << ", allowed: [0x00c0_0000-0x00cf_ffff]"
+    RequestDeadline::check();
+    RegisterOperation operation = registerPair.first;
+    const auto& args = registerPair.second;
+    address = args.at(0);
+
+    // Number of consecutive registers accessed by the operation
+    uint64_t count = 1;
+    if (operation == RegisterOperation::ReadBlock) {
+      count = args.at(1);
+    } else if (operation == RegisterOperation::WriteBlock) {
+      count = args.size() - 1;
+    }
+
+    // Blocks are bounded, and must fit in the BAR whatever the card type
+    if (operation == RegisterOperation::ReadBlock || operation == RegisterOperation::WriteBlock) {
+      if (count < 1 || count > kMaxBlockSize) {
+        BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message((boost::format("Invalid block size %d, allowed: [1-%d]") % count % kMaxBlockSize).str()));
+      }
+      if (address + count * 4 > bar->getBarSize()) {
+        BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message((boost::format("Block of %d registers at 0x%x exceeds the BAR size 0x%x") % count % address % bar->getBarSize()).str()));
+      }
+    }
+
+    // If it's a CRU, check address range; for blocks, check the whole range once
+    uint64_t lastAddress = address + (count - 1) * 4;
+    if (isCru && (address < 0x00c00000 || lastAddress > 0x00cfffff)) {
+      resultBuffer << "Illegal address 0x" << std::hex << address;
+      if (count > 1) {
+        resultBuffer << "-0x" << lastAddress;
+      }
+      resultBuffer << ", allowed: [0x00c0_0000-0x00cf_ffff]"
                    << "\n";
       BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message(resultBuffer.str()));
     }
 
-    if (registerPair.size() == 1) {
+    if (operation == RegisterOperation::Read) {
       value = bar->readRegister(address / 4);
       resultBuffer << Util::formatValue(value) << "\n";
-    } else if (registerPair.size() == 2) {
-      value = registerPair.at(1);
+    } else if (operation == RegisterOperation::Write) {
+      value = args.at(1);
       bar->writeRegister(address / 4, value);
       resultBuffer << "0"
                    << "\n";
+    } else if (operation == RegisterOperation::ReadBlock) {
+      // Read the whole block first, then format the values in one line
+      std::vector<uint32_t> values(count);
+      uint32_t index = address / 4;
+      for (uint32_t i = 0; i < count; i++) {
+        values[i] = bar->readRegister(index + i);
+      }
+      for (uint32_t i = 0; i < count; i++) {
+        resultBuffer << Util::formatValue(values[i]) << (i + 1 < count ? pairSeparator() : "\n");
+      }
+    } else if (operation == RegisterOperation::WriteBlock) {
+      uint32_t index = address / 4;
+      for (uint32_t i = 0; i < count; i++) {
+        bar->writeRegister(index + i, args[i + 1]);
+      }
+      resultBuffer << "0"
+                   << "\n";
+    } else if (operation == RegisterOperation::ReadModifyWrite) {
+      uint32_t mask = args.at(1);
+      // Hold the card's LLA session for the read and the write, unless it is already held
+      // The session is stopped by its destructor if the RMW fails
+      std::unique_ptr<LlaSession> session;
+      if (llaSession && !llaSession->isStarted()) {
+        session = std::make_unique<LlaSession>(llaSession, bar->getSerial().get_value_or(-1));
+        try {
+          session->start();
+        } catch (const lla::LlaException& e) {
+          BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("Could not start session for register RMW"));
+        }
+      }
+      value = (bar->readRegister(address / 4) & ~mask) | (args.at(2) & mask);
+      bar->writeRegister(address / 4, value);
+      if (session) {
+        session->stop();
+      }
+      resultBuffer << Util::formatValue(value) << "\n";
+    } else if (operation == RegisterOperation::Poll) {
+      uint32_t mask = args.at(1);
+      uint32_t expected = args.at(2);
+      int elapsed;
+      auto isDone = [&]() {
+        value = bar->readRegister(address / 4);
+        return (value & mask) == (expected & mask);
+      };
+      if (!Util::pollUntil(isDone, args.at(3), args.at(4), elapsed, RequestDeadline::check)) {
+        resultBuffer << "Poll timeout on address " << Util::formatValue(address) << " after " << std::dec << elapsed
+                     << " ms, last value=" << Util::formatValue(value) << "\n";
+        BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message(resultBuffer.str()));
+      }
+      resultBuffer << Util::formatValue(value) << "," << std::dec << elapsed << "\n";
     }
   }
   return resultBuffer.str();
 }
 
-std::string AlfServer::scaBlobWrite(const std::string& parameter, AlfLink link)
+std::string AlfServer::scaBlobWrite(const std::string& parameter, AlfLink link, LaneMutex::Priority priority)
 {
   std::vector<std::string> stringPairs = Util::split(parameter, argumentSeparator());
-  std::vector<std::pair<Sca::Operation, Sca::Data>> scaPairs = parseStringToScaPairs(stringPairs);
-  Sca sca = Sca(link, mSessions[link.serialId]);
+  bool optimize, dryRun;
+  takeDirectives(stringPairs, optimize, dryRun);
+  auto scaPairs = parseStringToScaPairs(stringPairs);
+  if (dryRun) {
+    return CostModel::format(CostModel(link).estimate(scaPairs, Sca::ScaOperationToString));
+  }
+  return executeScaSequence(scaPairs, link, priority, optimize);
+}
+
+std::shared_ptr<AlfServer::LinkContext> AlfServer::getLinkContext(AlfLink link)
+{
+  std::lock_guard<std::mutex> lock(mLinkContextsMutex);
+  auto& cardContexts = mLinkContexts[link.serialId.getSerial()];
+  auto it = cardContexts.find(link.rawLinkId);
+  return (it != cardContexts.end()) ? it->second : nullptr;
+}
+
+void AlfServer::checkScCore(AlfLink link, ScCore core)
+{
+  auto linkContext = getLinkContext(link);
+  if (linkContext && !(linkContext->scCores & core)) {
+    std::string name = (core == ScCore::ScaCore) ? "SCA" : (core == ScCore::SwtCore) ? "SWT" : "IC";
+    BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message((boost::format("%s core of link %d is masked out") % name % link.linkId).str()));
+  }
+}
+
+std::unique_ptr<LaneLock> AlfServer::lockLanes(AlfLink link, Lane lane, LaneMutex::Priority priority)
+{
+  auto linkContext = getLinkContext(link);
+  if (!linkContext) {
+    return nullptr;
+  }
+
+  // Lanes are always locked in the same order
+  std::vector<LaneMutex*> mutexes;
+  for (int i = 0; i < Lane::AllLanes; i++) {
+    if (lane == Lane::AllLanes || lane == i) {
+      mutexes.push_back(&linkContext->lanes[i]);
+    }
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  auto locks = std::make_unique<LaneLock>(mutexes, priority, RequestClient::virtualTime());
+  linkContext->laneWait[priority].add(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start));
+
+  // Don't run a request that expired while waiting for the lanes
+  RequestDeadline::shedIfExpired();
+  return locks;
+}
+
+std::unique_ptr<AlfServer::AdvisoryLock> AlfServer::lockAdvisory(AlfLink link, bool card, int timeout)
+{
+  auto linkContext = getLinkContext(link);
+  if (!linkContext) {
+    return nullptr;
+  }
+
+  std::shared_timed_mutex* cardLock;
+  {
+    std::lock_guard<std::mutex> lock(mLinkContextsMutex);
+    cardLock = &mCardLocks[link.serialId.getSerial()];
+  }
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+  auto acquire = [&](auto& lock, const std::string& name) {
+    if (timeout == 0) {
+      lock.lock();
+    } else if (!lock.try_lock_until(deadline)) {
+      BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("Couldn't lock " + name + " in " + std::to_string(timeout) + " ms"));
+    }
+  };
+
+  // The card lock is always taken before the link lock
+  auto advisoryLock = std::make_unique<AdvisoryLock>();
+  if (card) {
+    advisoryLock->card = std::unique_lock<std::shared_timed_mutex>(*cardLock, std::defer_lock);
+    acquire(advisoryLock->card, "card " + link.serialId.toString());
+  } else {
+    advisoryLock->sharedCard = std::shared_lock<std::shared_timed_mutex>(*cardLock, std::defer_lock);
+    acquire(advisoryLock->sharedCard, "card " + link.serialId.toString());
+    advisoryLock->link = std::unique_lock<std::timed_mutex>(linkContext->lock, std::defer_lock);
+    acquire(advisoryLock->link, "link " + std::to_string(link.linkId));
+  }
+  return advisoryLock;
+}
+
+std::string AlfServer::executeScaSequence(std::vector<std::pair<Sca::Operation, Sca::Data>> scaPairs, AlfLink link, LaneMutex::Priority priority, bool optimize)
+{
+  checkScCore(link, ScCore::ScaCore);
+
+  // sc_reset resets all the SC cores of the link
+  bool scReset = std::any_of(scaPairs.begin(), scaPairs.end(), [](const auto& scaPair) { return scaPair.first == Sca::Operation::SCReset; });
 
   bool lock = false;
   int lockTimeout = 0;
   // Check if the operation should be locked
+  if (scaPairs.empty()) {
+    BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("SCA sequence has no operations"));
+  }
   if (scaPairs[0].first == Sca::Operation::Lock) {
     lockTimeout = boost::get<int>(scaPairs[0].second);
     scaPairs.erase(scaPairs.begin());
     lock = true;
   }
-  return sca.writeSequence(scaPairs, lock, lockTimeout);
+
+  // A locked sequence runs without yielding its lanes, even when it doesn't need the card's LLA session
+  bool atomic = lock;
+  std::unique_ptr<AdvisoryLock> advisoryLock;
+  if (lock && mLinkLocks) {
+    advisoryLock = lockAdvisory(link, scReset, lockTimeout);
+    lock = scReset; // only sequences resetting the SC cores need the card's LLA session
+  }
+
+  auto locks = lockLanes(link, scReset ? Lane::AllLanes : Lane::ScaLane, priority);
+
+  Sca sca = Sca(link, mSessions[link.serialId]);
+  sca.setOperationCallback([&locks, atomic]() {
+    if (locks && !atomic) {
+      locks->yield();
+    }
+    RequestDeadline::check();
+  });
+
+  if (!optimize) {
+    return sca.writeSequence(scaPairs, lock, lockTimeout);
+  }
+
+  // Merged waits take as long, only the dropped operations save time
+  CostModel costModel(link);
+  SequenceOptimizer<Sca::Operation, Sca::Data> optimizer(scaPairs, foldScaOp, [&costModel](const auto& scaPair) {
+    return (scaPair.first == Sca::Operation::Wait) ? std::chrono::microseconds(0) : costModel.cost(scaPair);
+  });
+  auto out = sca.executeSequence(optimizer.sequence(), lock, lockTimeout);
+  optimizer.restore(out);
+  return Sca::formatSequenceOutput(out);
 }
 
 std::string AlfServer::scaMftPsuBlobWrite(const std::string& parameter, AlfLink link)
 {
+  checkScCore(link, ScCore::ScaCore);
+
   std::vector<std::string> stringPairs = Util::split(parameter, argumentSeparator());
   std::vector<std::pair<Sca::Operation, Sca::Data>> scaPairs = parseStringToScaPairs(stringPairs);
-  ScaMftPsu sca = ScaMftPsu(link, mSessions[link.serialId]);
 
   bool lock = false;
   // Check if the operation should be locked
+  if (scaPairs.empty()) {
+    BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("SCA MFT PSU sequence has no operations"));
+  }
   if (scaPairs[0].first == Sca::Operation::Lock) {
     scaPairs.erase(scaPairs.begin());
     lock = true;
   }
+
+  std::unique_ptr<AdvisoryLock> advisoryLock;
+  if (lock && mLinkLocks) {
+    advisoryLock = lockAdvisory(link, false, 0);
+    lock = false;
+  }
+
+  auto locks = lockLanes(link, Lane::ScaLane);
+  ScaMftPsu sca = ScaMftPsu(link, mSessions[link.serialId]);
   return sca.writeSequence(scaPairs, lock);
 }
 
-std::string AlfServer::swtBlobWrite(const std::string& parameter, AlfLink link)
+std::string AlfServer::swtBlobWrite(const std::string& parameter, AlfLink link, LaneMutex::Priority priority)
 {
-
   std::vector<std::string> stringPairs = Util::split(parameter, argumentSeparator());
-  std::vector<std::pair<Swt::Operation, Swt::Data>> swtPairs = parseStringToSwtPairs(stringPairs, mSwtWordSize);
-  Swt swt = Swt(link, mSessions[link.serialId], mSwtWordSize);
+  bool optimize, dryRun;
+  takeDirectives(stringPairs, optimize, dryRun);
+  auto swtPairs = parseStringToSwtPairs(stringPairs, mSwtWordSize);
+  if (dryRun) {
+    return CostModel::format(CostModel(link).estimate(swtPairs, Swt::SwtOperationToString));
+  }
+  return executeSwtSequence(swtPairs, link, priority, optimize);
+}
+
+std::string AlfServer::executeSwtSequence(std::vector<std::pair<Swt::Operation, Swt::Data>> swtPairs, AlfLink link, LaneMutex::Priority priority, bool optimize)
+{
+  checkScCore(link, ScCore::SwtCore);
+
+  // sc_reset resets all the SC cores of the link
+  bool scReset = std::any_of(swtPairs.begin(), swtPairs.end(), [](const auto& swtPair) { return swtPair.first == Swt::Operation::SCReset; });
 
   bool lock = false;
   int lockTimeout = 0;
   // Check if the operation should be locked
+  if (swtPairs.empty()) {
+    BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("SWT sequence has no operations"));
+  }
   if (swtPairs[0].first == Swt::Operation::Lock) {
     lockTimeout = boost::get<int>(swtPairs[0].second);
     lock = true;
     swtPairs.erase(swtPairs.begin());
   }
-  return swt.writeSequence(swtPairs, lock, lockTimeout);
+
+  // A locked sequence runs without yielding its lanes, even when it doesn't need the card's LLA session
+  bool atomic = lock;
+  std::unique_ptr<AdvisoryLock> advisoryLock;
+  if (lock && mLinkLocks) {
+    advisoryLock = lockAdvisory(link, scReset, lockTimeout);
+    lock = scReset; // only sequences resetting the SC cores need the card's LLA session
+  }
+
+  auto locks = lockLanes(link, scReset ? Lane::AllLanes : Lane::SwtLane, priority);
+
+  Swt swt = Swt(link, mSessions[link.serialId], mSwtWordSize);
+  swt.setOperationCallback([&locks, atomic]() {
+    if (locks && !atomic) {
+      locks->yield();
+    }
+    RequestDeadline::check();
+  });
+
+  if (!optimize) {
+    return swt.writeSequence(swtPairs, lock, lockTimeout);
+  }
+
+  // Merged waits take as long, only the dropped operations save time
+  CostModel costModel(link);
+  SequenceOptimizer<Swt::Operation, Swt::Data> optimizer(swtPairs, foldSwtOp, [&costModel](const auto& swtPair) {
+    return (swtPair.first == Swt::Operation::Wait) ? std::chrono::microseconds(0) : costModel.cost(swtPair);
+  });
+  auto out = swt.executeSequence(optimizer.sequence(), lock, lockTimeout);
+  optimizer.restore(out);
+  return Swt::formatSequenceOutput(out);
 }
 
-std::string AlfServer::icBlobWrite(const std::string& parameter, AlfLink link)
+std::string AlfServer::icBlobWrite(const std::string& parameter, AlfLink link, LaneMutex::Priority priority)
 {
-
   std::vector<std::string> stringPairs = Util::split(parameter, argumentSeparator());
-  std::vector<std::pair<Ic::Operation, Ic::Data>> icPairs = parseStringToIcPairs(stringPairs);
-  Ic ic = Ic(link, mSessions[link.serialId]);
+  bool optimize, dryRun;
+  takeDirectives(stringPairs, optimize, dryRun);
+  auto icPairs = parseStringToIcPairs(stringPairs);
+  if (dryRun) {
+    return CostModel::format(CostModel(link).estimate(icPairs, Ic::IcOperationToString));
+  }
+  return executeIcSequence(icPairs, link, priority, optimize);
+}
+
+std::string AlfServer::executeIcSequence(std::vector<std::pair<Ic::Operation, Ic::Data>> icPairs, AlfLink link, LaneMutex::Priority priority, bool optimize)
+{
+  checkScCore(link, ScCore::IcCore);
 
   bool lock = false;
   // Check if the operation should be locked
+  if (icPairs.empty()) {
+    BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("IC sequence has no operations"));
+  }
   if (icPairs[0].first == Ic::Operation::Lock) {
     icPairs.erase(icPairs.begin());
     lock = true;
   }
-  return ic.writeSequence(icPairs, lock);
+
+  // A locked sequence runs without yielding its lanes, even when it doesn't need the card's LLA session
+  bool atomic = lock;
+  std::unique_ptr<AdvisoryLock> advisoryLock;
+  if (lock && mLinkLocks) {
+    advisoryLock = lockAdvisory(link, false, 0);
+    lock = false;
+  }
+
+  auto locks = lockLanes(link, Lane::IcLane, priority);
+  Ic ic = Ic(link, mSessions[link.serialId]);
+  ic.setOperationCallback([&locks, atomic]() {
+    if (locks && !atomic) {
+      locks->yield();
+    }
+    RequestDeadline::check();
+  });
+
+  if (!optimize) {
+    return ic.writeSequence(icPairs, lock);
+  }
+
+  CostModel costModel(link);
+  SequenceOptimizer<Ic::Operation, Ic::Data> optimizer(icPairs, foldIcOp, [&costModel](const auto& icPair) { return costModel.cost(icPair); });
+  auto out = ic.executeSequence(optimizer.sequence(), lock);
+  optimizer.restore(out);
+  return Ic::formatSequenceOutput(out);
+}
+
+std::string AlfServer::scProgram(const std::string& parameter, AlfLink link)
+{
+  std::shared_ptr<const ScProgram> program;
+  {
+    std::lock_guard<std::mutex> lock(mScProgramsMutex);
+    auto it = mScPrograms.find(parameter);
+    if (it != mScPrograms.end()) {
+      program = it->second;
+    }
+  }
+
+  if (!program) {
+    program = std::make_shared<const ScProgram>(Util::split(parameter, argumentSeparator()));
+    std::lock_guard<std::mutex> lock(mScProgramsMutex);
+    if (mScPrograms.size() >= kMaxCachedScPrograms) {
+      mScPrograms.clear();
+    }
+    mScPrograms[parameter] = program;
+  }
+
+  return runScProgram(*program, link);
+}
+
+std::string AlfServer::runScProgram(const ScProgram& program, AlfLink link)
+{
+  if (program.usesSca()) {
+    checkScCore(link, ScCore::ScaCore);
+  }
+  if (program.usesSwt()) {
+    checkScCore(link, ScCore::SwtCore);
+  }
+  if (program.usesIc()) {
+    checkScCore(link, ScCore::IcCore);
+  }
+
+  // Programs may use any of the SC cores
+  auto locks = lockLanes(link, Lane::AllLanes);
+  return program.run(link, mSessions[link.serialId], mSwtWordSize);
+}
+
+std::string AlfServer::runSection(const std::string& type, const std::vector<std::string>& lines, AlfLink link)
+{
+  std::string section = boost::algorithm::join(lines, argumentSeparator());
+  if (type == "sca") {
+    auto linkContext = getLinkContext(link);
+    bool mftPsu = linkContext ? linkContext->mftPsu : ScaMftPsu::isAnMftPsuLink(link);
+    return mftPsu ? scaMftPsuBlobWrite(section, link) : scaBlobWrite(section, link);
+  } else if (type == "swt") {
+    return swtBlobWrite(section, link);
+  } else if (type == "ic") {
+    return icBlobWrite(section, link);
+  } else if (type == "program") {
+    return scProgram(section, link);
+  } else if (type == "stored") {
+    return runStoredSequence(section, link);
+  }
+  BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("Invalid CARD_SEQUENCE section type: '" + type + "'"));
+}
+
+std::string AlfServer::asyncSequence(const std::string& parameter, AlfLink link)
+{
+  static const std::vector<std::string> types = { "sca", "swt", "ic", "program", "stored" };
+  size_t typeEnd = parameter.find(argumentSeparator());
+  std::string type = boost::trim_copy(parameter.substr(0, typeEnd));
+  if (std::find(types.begin(), types.end(), type) == types.end()) {
+    BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("Invalid ASYNC_SEQUENCE type: '" + type + "'"));
+  }
+  std::vector<std::string> lines;
+  if (typeEnd != std::string::npos) {
+    lines = Util::split(parameter.substr(typeEnd + 1), argumentSeparator());
+  }
+
+  std::shared_ptr<LinkContext> linkContext;
+  {
+    std::lock_guard<std::mutex> lock(mLinkContextsMutex);
+    auto& cardContexts = mLinkContexts[link.serialId.getSerial()];
+    auto it = cardContexts.find(link.rawLinkId);
+    if (it != cardContexts.end()) {
+      linkContext = it->second;
+    }
+  }
+
+  uint64_t jobId;
+  {
+    std::lock_guard<std::mutex> lock(mAsyncJobsMutex);
+    if (mAsyncJobs.size() >= kMaxAsyncJobs) {
+      // Forget the oldest completed job, whose result should have been collected by now
+      auto it = std::find_if(mAsyncJobs.begin(), mAsyncJobs.end(), [](const auto& job) { return job.second.done; });
+      if (it == mAsyncJobs.end()) {
+        BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("Too many async sequences running"));
+      }
+      mAsyncJobs.erase(it);
+    }
+    jobId = mNextAsyncJobId++;
+    mAsyncJobs[jobId];
+  }
+
+  // Keyed on the link, so that the async sequences of a link run in order, along with its card sequence sections
+  uint64_t key = ((uint64_t)link.serialId.getSerial() << 32) | (uint32_t)link.rawLinkId;
+  auto client = RequestClient::get();
+  mWorkerPool->submit(key, [type, lines, link, linkContext, jobId, client, this]() {
+    RequestClient::set(client);
+    std::string result;
+    bool failed = false;
+    try {
+      result = runSection(type, lines, link);
+    } catch (const std::exception& e) {
+      result = e.what();
+      failed = true;
+    }
+    RequestClient::set("");
+
+    std::string status = std::to_string(jobId) + pairSeparator() + (failed ? "failed" : "done") + argumentSeparator();
+    {
+      std::lock_guard<std::mutex> lock(mAsyncJobsMutex);
+      auto it = mAsyncJobs.find(jobId);
+      if (it != mAsyncJobs.end()) {
+        it->second = { true, failed, result };
+      }
+    }
+    if (linkContext) {
+      std::lock_guard<std::mutex> lock(linkContext->sequenceResultMutex);
+      linkContext->sequenceResult = toCharBuffer(status + result);
+      if (linkContext->sequenceResultService) {
+        linkContext->sequenceResultService->updateService(linkContext->sequenceResult.data());
+      }
+    }
+  });
+
+  return std::to_string(jobId);
+}
+
+std::string AlfServer::asyncResult(const std::string& parameter)
+{
+  uint64_t jobId;
+  try {
+    jobId = std::stoull(boost::trim_copy(parameter));
+  } catch (const std::exception& e) {
+    BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("Invalid ASYNC_RESULT job id: '" + parameter + "'"));
+  }
+
+  std::lock_guard<std::mutex> lock(mAsyncJobsMutex);
+  auto it = mAsyncJobs.find(jobId);
+  if (it == mAsyncJobs.end()) {
+    BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("Unknown async sequence job id: " + std::to_string(jobId)));
+  }
+  const auto& job = it->second;
+  std::string status = !job.done ? "running" : (job.failed ? "failed" : "done");
+  return std::to_string(jobId) + pairSeparator() + status + argumentSeparator() + job.result;
+}
+
+std::string AlfServer::cardSequence(const std::string& parameter, int serial)
+{
+  struct Section {
+    int rawLinkId;
+    std::string type;
+    std::vector<std::string> lines;
+    std::string result;
+    bool failed;
+  };
+
+  // Split the payload into link sections
+  std::vector<Section> sections;
+  for (const auto& line : Util::split(parameter, argumentSeparator())) {
+    std::vector<std::string> tokens = Util::split(line, pairSeparator());
+    if (line.find('#') == std::string::npos && tokens.size() == 3 && boost::trim_copy(tokens[2]) == "link") {
+      try {
+        sections.push_back({ std::stoi(tokens[0]), boost::trim_copy(tokens[1]), {}, "", false });
+      } catch (const std::exception& e) {
+        BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("Invalid CARD_SEQUENCE link: " + line));
+      }
+    } else if (sections.empty()) {
+      BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("CARD_SEQUENCE needs to start with a link section"));
+    } else {
+      sections.back().lines.push_back(line);
+    }
+  }
+
+  // Group the sections by link; sections of the same link run in order
+  std::map<int, std::vector<size_t>> linkSections;
+  for (size_t i = 0; i < sections.size(); i++) {
+    linkSections[sections[i].rawLinkId].push_back(i);
+  }
+
+  std::map<int, std::shared_ptr<LinkContext>> linkContexts;
+  {
+    std::lock_guard<std::mutex> lock(mLinkContextsMutex);
+    for (const auto& linkSection : linkSections) {
+      auto it = mLinkContexts[serial].find(linkSection.first);
+      if (it == mLinkContexts[serial].end()) {
+        BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message((boost::format("Link %d not available on serial %d") % linkSection.first % serial).str()));
+      }
+      linkContexts[linkSection.first] = it->second;
+    }
+  }
+
+  std::vector<std::future<void>> futures;
+  for (const auto& linkSection : linkSections) {
+    auto linkContext = linkContexts[linkSection.first];
+    auto indices = linkSection.second;
+    // Keyed on the link, so that the sections of concurrent card sequences on a link run in order
+    uint64_t key = ((uint64_t)serial << 32) | (uint32_t)linkSection.first;
+    bool hasDeadline = RequestDeadline::isSet();
+    auto deadline = RequestDeadline::get();
+    auto client = RequestClient::get();
+    futures.push_back(mWorkerPool->submit(key, [&sections, linkContext, indices, hasDeadline, deadline, client, this]() {
+      // Sections share the deadline and the client of the card sequence
+      if (hasDeadline) {
+        RequestDeadline::set(deadline);
+      }
+      RequestClient::set(client);
+      for (auto i : indices) {
+        try {
+          sections[i].result = runSection(sections[i].type, sections[i].lines, linkContext->link);
+        } catch (const std::exception& e) {
+          sections[i].result = e.what();
+          sections[i].failed = true;
+        }
+      }
+      RequestClient::set("");
+      RequestDeadline::clear();
+    }));
+  }
+  for (auto& future : futures) {
+    future.wait();
+  }
+
+  std::stringstream resultBuffer;
+  bool failed = false;
+  for (const auto& section : sections) {
+    resultBuffer << section.rawLinkId << pairSeparator() << section.type << pairSeparator() << "link\n"
+                 << section.result;
+    if (!section.result.empty() && section.result.back() != '\n') {
+      resultBuffer << "\n";
+    }
+    failed |= section.failed;
+  }
+
+  if (failed) {
+    BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message(resultBuffer.str()));
+  }
+  return resultBuffer.str();
+}
+
+std::string AlfServer::statistics(const std::string& /*parameter*/, int serial)
+{
+  std::vector<std::shared_ptr<LinkContext>> linkContexts;
+  {
+    std::lock_guard<std::mutex> lock(mLinkContextsMutex);
+    for (const auto& linkContext : mLinkContexts[serial]) {
+      linkContexts.push_back(linkContext.second);
+    }
+  }
+
+  std::stringstream resultBuffer;
+  for (int priority = 0; priority < LaneMutex::NumPriorities; priority++) {
+    uint64_t count = 0, total = 0, max = 0;
+    for (const auto& linkContext : linkContexts) {
+      auto latency = linkContext->laneWait[priority].get();
+      count += latency[0];
+      total += latency[0] * latency[1];
+      max = std::max(max, latency[2]);
+    }
+    std::string name = (priority == LaneMutex::High) ? "high" : "normal";
+    resultBuffer << name << "_priority_requests," << count << "\n"
+                 << name << "_priority_lane_wait_avg_us," << (count ? total / count : 0) << "\n"
+                 << name << "_priority_lane_wait_max_us," << max << "\n";
+  }
+
+  int laneWaiting = 0;
+  for (const auto& linkContext : linkContexts) {
+    for (auto& lane : linkContext->lanes) {
+      laneWaiting += lane.waiting();
+    }
+  }
+  resultBuffer << "lane_waiting," << laneWaiting << "\n"
+               << "rpc_in_flight," << RequestDeadline::inFlight << "\n"
+               << "rpc_shed," << RequestDeadline::shed << "\n"
+               << "rpc_aborted," << RequestDeadline::aborted << "\n";
+  resultBuffer << "optimized_sequences," << SequenceOptimizerStatistics::sequences << "\n"
+               << "optimizer_ops_removed," << SequenceOptimizerStatistics::opsRemoved << "\n"
+               << "optimizer_saved_us," << SequenceOptimizerStatistics::savedUs << "\n";
+  resultBuffer << "swt_skipped_writes," << SwtWriteCacheStatistics::skippedWrites << "\n";
+  resultBuffer << "lla_lease_reused," << LlaLeaseStatistics::reused << "\n"
+               << "lla_lease_preempted," << LlaLeaseStatistics::preempted << "\n"
+               << "lla_lease_expired," << LlaLeaseStatistics::expired << "\n";
+
+  for (const auto& client : RequestClient::statistics()) {
+    std::string name = "client_" + client.name;
+    resultBuffer << name << "_requests," << client.requests << "\n"
+                 << name << "_rejected," << client.rejected << "\n"
+                 << name << "_rate_hz," << std::fixed << std::setprecision(2) << client.rate << "\n"
+                 << name << "_time_us," << client.timeUs << "\n";
+  }
+
+  static const std::array<std::string, ScBase::NumTimeoutKinds> timeoutNames = { "sca", "swt", "ic" };
+  for (const auto& linkContext : linkContexts) {
+    for (int kind = 0; kind < ScBase::NumTimeoutKinds; kind++) {
+      auto timeoutKind = static_cast<ScBase::TimeoutKind>(kind);
+      std::string name = "link_" + std::to_string(linkContext->link.rawLinkId) + "_" + timeoutNames[kind];
+      resultBuffer << name << "_latency_p999_us," << ScBase::getLatencyQuantile(linkContext->link, timeoutKind).count() << "\n"
+                   << name << "_timeout_us," << ScBase::getTimeout(linkContext->link, timeoutKind).count() << "\n";
+    }
+  }
+  return resultBuffer.str();
+}
+
+std::string AlfServer::lockStatus(int serial)
+{
+  static const std::array<std::string, LlaLockStatistics::kNumBuckets> buckets = { "lt_10us", "lt_100us", "lt_1ms", "lt_10ms", "lt_100ms", "lt_1s", "ge_1s" };
+  auto statistics = LlaSession::getLockStatistics(serial);
+
+  std::stringstream resultBuffer;
+  resultBuffer << "holder," << statistics.holder << "\n"
+               << "acquisitions," << statistics.acquisitions << "\n"
+               << "failures," << statistics.failures << "\n";
+  for (int i = 0; i < LlaLockStatistics::kNumBuckets; i++) {
+    resultBuffer << "wait_" << buckets[i] << "," << statistics.wait[i] << "\n";
+  }
+  for (int i = 0; i < LlaLockStatistics::kNumBuckets; i++) {
+    resultBuffer << "hold_" << buckets[i] << "," << statistics.hold[i] << "\n";
+  }
+  return resultBuffer.str();
+}
+
+void AlfServer::storeSequence(const std::string& name, const std::string& type, const std::vector<std::string>& lines)
+{
+  static const std::vector<std::string> types = { "register", "sca", "swt", "ic", "program" };
+  if (name.empty() || name.find_first_of(" ,$#") != std::string::npos) {
+    BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("Invalid stored sequence name: '" + name + "'"));
+  }
+  if (std::find(types.begin(), types.end(), type) == types.end()) {
+    BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("Invalid stored sequence type: '" + type + "'"));
+  }
+  size_t size = 0;
+  for (const auto& line : lines) {
+    size += line.size() + 1;
+  }
+  if (size > kMaxStoredSequenceSize) {
+    BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message((boost::format("Stored sequence '%s' of %d bytes exceeds the maximum of %d bytes") % name % size % kMaxStoredSequenceSize).str()));
+  }
+
+  auto storedSequence = std::make_shared<StoredSequence>();
+  storedSequence->type = type;
+  storedSequence->lines = lines;
+  storedSequence->parameterCount = 0;
+
+  // Find the highest parameter placeholder ($1, $2, ...)
+  for (const auto& line : lines) {
+    for (size_t pos = line.find('$'); pos != std::string::npos; pos = line.find('$', pos + 1)) {
+      size_t end = line.find_first_not_of("0123456789", pos + 1);
+      std::string index = line.substr(pos + 1, end - (pos + 1));
+      // Validate the index before converting it, as stoi throws on overflow
+      if (index.empty() || index.size() > 2 || std::stoi(index) < 1) {
+        BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("Invalid parameter placeholder in stored sequence '" + name + "': " + line));
+      }
+      storedSequence->parameterCount = std::max(storedSequence->parameterCount, std::stoi(index));
+    }
+  }
+
+  // Without parameters the sequence can be parsed, and validated, right away
+  if (storedSequence->parameterCount == 0) {
+    storedSequence->parsed[{}] = parseSequence(type, lines);
+  }
+
+  std::lock_guard<std::mutex> lock(mStoredSequencesMutex);
+  if (mStoredSequences.size() >= kMaxStoredSequences && mStoredSequences.find(name) == mStoredSequences.end()) {
+    BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message((boost::format("Maximum number of %d stored sequences reached, cannot store '%s'") % kMaxStoredSequences % name).str()));
+  }
+  mStoredSequences[name] = storedSequence;
+}
+
+AlfServer::ParsedSequence AlfServer::parseSequence(const std::string& type, const std::vector<std::string>& lines)
+{
+  if (type == "register") {
+    return parseStringToRegisterPairs(lines);
+  } else if (type == "sca") {
+    return parseStringToScaPairs(lines);
+  } else if (type == "swt") {
+    return parseStringToSwtPairs(lines, mSwtWordSize);
+  } else if (type == "ic") {
+    return parseStringToIcPairs(lines);
+  } else {
+    return std::make_shared<const ScProgram>(lines);
+  }
+}
+
+void AlfServer::loadSequences(const std::string& directory)
+{
+  for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+    if (!entry.is_regular_file()) {
+      continue;
+    }
+    std::string name = entry.path().stem().string();
+    std::string type = entry.path().extension().string();
+    if (!type.empty()) {
+      type.erase(0, 1); // drop the leading dot
+    }
+
+    std::ifstream file(entry.path());
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(file, line);) {
+      lines.push_back(line);
+    }
+
+    try {
+      storeSequence(name, type, lines);
+      Logger::get() << "Loaded stored sequence " << name << " (" << type << ")" << LogInfoDevel_(5010) << endm;
+    } catch (const std::exception& e) {
+      // The parsers also throw standard exceptions, e.g. on unknown operations or invalid values
+      Logger::get() << "Skipping " << entry.path().string() << ": " << boost::diagnostic_information(e, true) << LogWarningOps_(5011) << endm;
+    }
+  }
+}
+
+std::string AlfServer::storeSequenceRpc(const std::string& parameter)
+{
+  std::vector<std::string> lines = Util::split(parameter, argumentSeparator());
+  std::vector<std::string> header = Util::split(lines.at(0), pairSeparator());
+  if (header.size() != 2) {
+    BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("STORE_SEQUENCE needs to start with the sequence name and type"));
+  }
+  lines.erase(lines.begin());
+  storeSequence(boost::trim_copy(header[0]), boost::trim_copy(header[1]), lines);
+  return "";
+}
+
+std::string AlfServer::runStoredSequence(const std::string& parameter, AlfLink link)
+{
+  std::vector<std::string> parameters = Util::split(parameter, argumentSeparator());
+  std::string name = boost::trim_copy(parameters.at(0));
+  parameters.erase(parameters.begin());
+
+  std::shared_ptr<StoredSequence> storedSequence;
+  ParsedSequence parsedSequence;
+  bool parsed = false;
+  {
+    std::lock_guard<std::mutex> lock(mStoredSequencesMutex);
+    auto it = mStoredSequences.find(name);
+    if (it == mStoredSequences.end()) {
+      BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("No stored sequence named '" + name + "'"));
+    }
+    storedSequence = it->second;
+    auto parsedIt = storedSequence->parsed.find(parameters);
+    if (parsedIt != storedSequence->parsed.end()) {
+      parsedSequence = parsedIt->second;
+      parsed = true;
+    }
+  }
+
+  if (!parsed) {
+    if ((int)parameters.size() != storedSequence->parameterCount) {
+      BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message((boost::format("Stored sequence '%s' takes %d parameters, %d given") % name % storedSequence->parameterCount % parameters.size()).str()));
+    }
+    for (const auto& p : parameters) {
+      if (p.find_first_of(",$") != std::string::npos) {
+        BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("Invalid stored sequence parameter: '" + p + "'"));
+      }
+    }
+
+    // Substitute the parameters, highest index first so that $1 doesn't match $10
+    std::vector<std::string> lines = storedSequence->lines;
+    for (auto& line : lines) {
+      for (int i = storedSequence->parameterCount; i >= 1; i--) {
+        boost::replace_all(line, "$" + std::to_string(i), boost::trim_copy(parameters[i - 1]));
+      }
+    }
+    parsedSequence = parseSequence(storedSequence->type, lines);
+
+    std::lock_guard<std::mutex> lock(mStoredSequencesMutex);
+    if (storedSequence->parsed.size() >= kMaxParsedPerStoredSequence) {
+      storedSequence->parsed.clear();
+    }
+    storedSequence->parsed[parameters] = parsedSequence;
+  }
+
+  if (storedSequence->type == "register") {
+    return executeRegisterSequence(boost::get<std::vector<RegisterPair>>(parsedSequence), link.bar, link.cardType == roc::CardType::Cru, mSessions[link.serialId]);
+  } else if (storedSequence->type == "sca") {
+    return executeScaSequence(boost::get<std::vector<std::pair<Sca::Operation, Sca::Data>>>(parsedSequence), link);
+  } else if (storedSequence->type == "swt") {
+    return executeSwtSequence(boost::get<std::vector<std::pair<Swt::Operation, Swt::Data>>>(parsedSequence), link);
+  } else if (storedSequence->type == "ic") {
+    return executeIcSequence(boost::get<std::vector<std::pair<Ic::Operation, Ic::Data>>>(parsedSequence), link);
+  } else {
+    return runScProgram(*boost::get<std::shared_ptr<const ScProgram>>(parsedSequence), link);
+  }
 }
 
 std::string AlfServer::icGbtI2cWrite(const std::string& parameter, AlfLink link)
@@ -143,6 +1090,7 @@ std::string AlfServer::icGbtI2cWrite(const std::string& parameter, AlfLink link)
 
   uint32_t value = Util::stringToHex(params[0]);
 
+  auto locks = lockLanes(link, Lane::IcLane);
   Ic ic = Ic(link, mSessions[link.serialId]);
   ic.writeGbtI2c(value);
   return "";
@@ -180,15 +1128,14 @@ std::string AlfServer::llaSessionStart(const std::string& parameter, roc::Serial
     // TODO: Update session name?
   }*/
 
-  if (parameters.size() == 2) {
-    if (!mSessions[serialId]->timedStart(std::stoi(parameters[1]))) {
-      BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("Could not start session for serial " + serialId.toString()));
-    }
-  } else {
-    if (!mSessions[serialId]->start()) {
-      BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("Could not start session for serial " + serialId.toString()));
-    }
+  LlaSession session(mSessions[serialId], serialId);
+  try {
+    session.start((parameters.size() == 2) ? std::stoi(parameters[1]) : 0);
+  } catch (const lla::LlaException& e) {
+    BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("Could not start session for serial " + serialId.toString()));
   }
+  // The client holds the session until LLA_SESSION_STOP, rather than a lease
+  session.detach();
   return "";
 }
 
@@ -198,7 +1145,7 @@ std::string AlfServer::llaSessionStop(const std::string& /*parameter*/, roc::Ser
     BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("Session was not started for serial  " + serialId.toString()));
   }
 
-  mSessions[serialId]->stop();
+  LlaSession(mSessions[serialId], serialId).stop();
   return "";
 }
 
@@ -225,14 +1172,77 @@ roc::PatternPlayer::Info AlfServer::parseStringToPatternPlayerInfo(const std::ve
   return roc::PatternPlayer::getInfoFromString(parameters);
 }
 
-std::vector<uint32_t> AlfServer::stringToRegisterPair(const std::string stringPair)
+AlfServer::RegisterPair AlfServer::stringToRegisterPair(const std::string stringPair)
 {
   std::vector<uint32_t> registers;
   auto stringRegisters = Util::split(stringPair, pairSeparator());
-  for (const auto& stringRegister : stringRegisters) {
-    registers.push_back(Util::stringToHex(stringRegister));
+
+  if (stringRegisters.size() < 1) {
+    BOOST_THROW_EXCEPTION(
+      AlfException() << ErrorInfo::Message("Register pair not formatted correctly"));
+  }
+
+  RegisterOperation operation;
+  if (stringRegisters[stringRegisters.size() - 1] == "read_block") { // addr,count,read_block
+    operation = RegisterOperation::ReadBlock;
+    if (stringRegisters.size() != 3) {
+      BOOST_THROW_EXCEPTION(
+        AlfException() << ErrorInfo::Message("Wrong number of arguments for READ BLOCK operation"));
+    }
+    registers.push_back(Util::stringToHex(stringRegisters[0]));
+    int count;
+    try {
+      count = std::stoi(stringRegisters[1]);
+    } catch (const std::exception& e) {
+      BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("READ BLOCK count provided cannot be converted to int"));
+    }
+    if (count < 1) {
+      BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("READ BLOCK count needs to be positive"));
+    }
+    registers.push_back(count);
+  } else if (stringRegisters[stringRegisters.size() - 1] == "poll") { // addr,mask,expected,interval,timeout,poll
+    operation = RegisterOperation::Poll;
+    if (stringRegisters.size() != 6) {
+      BOOST_THROW_EXCEPTION(
+        AlfException() << ErrorInfo::Message("Wrong number of arguments for POLL operation"));
+    }
+    for (size_t i = 0; i < 3; i++) {
+      registers.push_back(Util::stringToHex(stringRegisters[i]));
+    }
+    auto timing = stringToPollTiming(stringRegisters[3], stringRegisters[4]);
+    registers.push_back(timing.first);
+    registers.push_back(timing.second);
+  } else if (stringRegisters[stringRegisters.size() - 1] == "rmw") { // addr,mask,value,rmw
+    operation = RegisterOperation::ReadModifyWrite;
+    if (stringRegisters.size() != 4) {
+      BOOST_THROW_EXCEPTION(
+        AlfException() << ErrorInfo::Message("Wrong number of arguments for RMW operation"));
+    }
+    for (size_t i = 0; i < 3; i++) {
+      registers.push_back(Util::stringToHex(stringRegisters[i]));
+    }
+  } else if (stringRegisters.size() > 1 && stringRegisters[1] == "write_block") { // addr,write_block,v1,v2,...
+    operation = RegisterOperation::WriteBlock;
+    if (stringRegisters.size() < 3) {
+      BOOST_THROW_EXCEPTION(
+        AlfException() << ErrorInfo::Message("Too few arguments for WRITE BLOCK operation"));
+    }
+    registers.push_back(Util::stringToHex(stringRegisters[0]));
+    for (size_t i = 2; i < stringRegisters.size(); i++) {
+      registers.push_back(Util::stringToHex(stringRegisters[i]));
+    }
+  } else {
+    if (stringRegisters.size() > 2) {
+      BOOST_THROW_EXCEPTION(
+        AlfException() << ErrorInfo::Message("Too many arguments for register operation"));
+    }
+    operation = (stringRegisters.size() == 1) ? RegisterOperation::Read : RegisterOperation::Write;
+    for (const auto& stringRegister : stringRegisters) {
+      registers.push_back(Util::stringToHex(stringRegister));
+    }
   }
-  return registers;
+
+  return std::make_pair(operation, registers);
 }
 
 std::pair<Sca::Operation, Sca::Data> AlfServer::stringToScaPair(const std::string stringPair)
@@ -242,12 +1252,37 @@ std::pair<Sca::Operation, Sca::Data> AlfServer::stringToScaPair(const std::strin
   Sca::Data data;
   Sca::Operation operation;
 
-  if (scaPair.size() < 1 || scaPair.size() > 2) {
+  if (scaPair.size() < 1 || (scaPair.size() > 2 && scaPair[scaPair.size() - 1] != "rmw" && scaPair[scaPair.size() - 1] != "poll")) {
     BOOST_THROW_EXCEPTION(
       AlfException() << ErrorInfo::Message("SCA command-data pair not formatted correctly"));
   }
 
-  if (scaPair[scaPair.size() - 1] == "lock") {
+  if (scaPair[scaPair.size() - 1] == "rmw") { // read_cmd,write_cmd,mask,data,rmw
+    operation = Sca::Operation::ReadModifyWrite;
+    if (scaPair.size() != 5) {
+      BOOST_THROW_EXCEPTION(
+        AlfException() << ErrorInfo::Message("Wrong number of arguments for RMW operation"));
+    }
+    Sca::RmwData rmwData;
+    rmwData.readCommand = Util::stringToHex(scaPair[0]);
+    rmwData.writeCommand = Util::stringToHex(scaPair[1]);
+    rmwData.mask = Util::stringToHex(scaPair[2]);
+    rmwData.data = Util::stringToHex(scaPair[3]);
+    data = rmwData;
+  } else if (scaPair[scaPair.size() - 1] == "poll") { // cmd,data,mask,expected,interval,timeout,poll
+    operation = Sca::Operation::Poll;
+    if (scaPair.size() != 7) {
+      BOOST_THROW_EXCEPTION(
+        AlfException() << ErrorInfo::Message("Wrong number of arguments for POLL operation"));
+    }
+    Sca::PollData pollData;
+    pollData.commandData.command = Util::stringToHex(scaPair[0]);
+    pollData.commandData.data = Util::stringToHex(scaPair[1]);
+    pollData.mask = Util::stringToHex(scaPair[2]);
+    pollData.expected = Util::stringToHex(scaPair[3]);
+    std::tie(pollData.interval, pollData.timeout) = stringToPollTiming(scaPair[4], scaPair[5]);
+    data = pollData;
+  } else if (scaPair[scaPair.size() - 1] == "lock") {
     operation = Sca::Operation::Lock;
     if (scaPair.size() == 2) {
       try {
@@ -318,7 +1353,7 @@ std::pair<Sca::Operation, Sca::Data> AlfServer::stringToScaPair(const std::strin
 std::pair<Swt::Operation, Swt::Data> AlfServer::stringToSwtPair(const std::string stringPair, const SwtWord::Size swtWordSize)
 {
   std::vector<std::string> swtPair = Util::split(stringPair, pairSeparator());
-  if (swtPair.size() < 1 || swtPair.size() > 2) {
+  if (swtPair.size() < 1 || (swtPair.size() > 2 && swtPair[swtPair.size() - 1] != "poll")) {
     BOOST_THROW_EXCEPTION(
       AlfException() << ErrorInfo::Message("SWT word pair not formatted correctly"));
   }
@@ -357,6 +1392,12 @@ std::pair<Swt::Operation, Swt::Data> AlfServer::stringToSwtPair(const std::strin
     case Swt::Operation::SCReset:
       numberOfMandatoryParams = 0;
       break;
+    case Swt::Operation::WordSize:
+      numberOfMandatoryParams = 1;
+      break;
+    case Swt::Operation::Poll:
+      numberOfMandatoryParams = 5;
+      break;
     case Swt::Operation::Wait:
       data = Swt::DEFAULT_SWT_WAIT_TIME_MS;
       getIntParam = true;
@@ -384,39 +1425,78 @@ std::pair<Swt::Operation, Swt::Data> AlfServer::stringToSwtPair(const std::strin
     }
   }
 
+  // special handling of the word size parameter
+  if (operation == Swt::Operation::WordSize) {
+    try {
+      data = SwtWord::sizeFromString(swtPair[0]);
+    } catch (const ParseException& e) {
+      BOOST_THROW_EXCEPTION(SwtException() << ErrorInfo::Message("SWT size argument provided cannot be converted to a word size (low, med, high)"));
+    }
+  }
+
   // special handling of the write parameter
   if (operation == Swt::Operation::Write) {
-    SwtWord word;
-    word.setSize(swtWordSize);
-    std::string hexString = swtPair[0];
-    std::string leadingHex = "0x";
+    data = stringToSwtWord(swtPair[0], swtWordSize);
+  }
 
-    std::string::size_type i = hexString.find(leadingHex);
-    if (i != std::string::npos) {
-      hexString.erase(i, leadingHex.size());
-    }
+  // special handling of the poll parameters: word,mask,expected,interval,timeout,poll
+  if (operation == Swt::Operation::Poll) {
+    Swt::PollData pollData;
+    pollData.word = stringToSwtWord(swtPair[0], swtWordSize);
+    pollData.mask = stringToSwtWord(swtPair[1], swtWordSize);
+    pollData.expected = stringToSwtWord(swtPair[2], swtWordSize);
+    std::tie(pollData.interval, pollData.timeout) = stringToPollTiming(swtPair[3], swtPair[4]);
+    data = pollData;
+  }
 
-    if (hexString.length() > 19) {
-      BOOST_THROW_EXCEPTION(std::out_of_range("SWT write argument does not fit in 76-bit unsigned int"));
-    }
+  return std::make_pair(operation, data);
+}
 
-    std::stringstream ss;
-    ss << std::setw(19) << std::setfill('0') << hexString;
+/// Converts a 76-bit hex number string
+SwtWord AlfServer::stringToSwtWord(const std::string hexWord, const SwtWord::Size swtWordSize)
+{
+  SwtWord word;
+  word.setSize(swtWordSize);
+  std::string hexString = hexWord;
+  std::string leadingHex = "0x";
 
-    word.setHigh(std::stoul(ss.str().substr(0, 3), NULL, 16));
-    word.setMed(std::stoul(ss.str().substr(3, 8), NULL, 16));
-    word.setLow(std::stoul(ss.str().substr(11, 8), NULL, 16));
+  std::string::size_type i = hexString.find(leadingHex);
+  if (i != std::string::npos) {
+    hexString.erase(i, leadingHex.size());
+  }
 
-    data = word;
+  if (hexString.length() > 19) {
+    BOOST_THROW_EXCEPTION(std::out_of_range("SWT write argument does not fit in 76-bit unsigned int"));
   }
 
-  return std::make_pair(operation, data);
+  std::stringstream ss;
+  ss << std::setw(19) << std::setfill('0') << hexString;
+
+  word.setHigh(std::stoul(ss.str().substr(0, 3), NULL, 16));
+  word.setMed(std::stoul(ss.str().substr(3, 8), NULL, 16));
+  word.setLow(std::stoul(ss.str().substr(11, 8), NULL, 16));
+
+  return word;
+}
+
+std::pair<int, int> AlfServer::stringToPollTiming(const std::string interval, const std::string timeout)
+{
+  std::pair<int, int> timing;
+  try {
+    timing = std::make_pair(std::stoi(interval), std::stoi(timeout));
+  } catch (const std::exception& e) {
+    BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("POLL interval and timeout provided cannot be converted to int"));
+  }
+  if (timing.first < kMinPollInterval || timing.second < 0 || timing.second > kMaxPollTimeout) {
+    BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message((boost::format("Invalid POLL interval %d and timeout %d, allowed: interval >= %d ms, timeout [0-%d] ms") % timing.first % timing.second % kMinPollInterval % kMaxPollTimeout).str()));
+  }
+  return timing;
 }
 
 std::pair<Ic::Operation, Ic::Data> AlfServer::stringToIcPair(const std::string stringPair)
 {
   std::vector<std::string> icPair = Util::split(stringPair, pairSeparator());
-  if (icPair.size() < 1 || icPair.size() > 3) {
+  if (icPair.size() < 1 || (icPair.size() > 3 && icPair[icPair.size() - 1] != "poll")) {
     BOOST_THROW_EXCEPTION(
       AlfException() << ErrorInfo::Message("IC pair not formatted correctly"));
   }
@@ -424,6 +1504,20 @@ std::pair<Ic::Operation, Ic::Data> AlfServer::stringToIcPair(const std::string s
   Ic::Operation icOperation;
   Ic::IcData icData;
 
+  if (icPair[icPair.size() - 1] == "poll") { // addr,mask,expected,interval,timeout,poll
+    icOperation = Ic::Operation::Poll;
+    if (icPair.size() != 6) {
+      BOOST_THROW_EXCEPTION(
+        AlfException() << ErrorInfo::Message("Wrong number of arguments for POLL operation"));
+    }
+    Ic::PollData pollData;
+    pollData.address = Util::stringToHex(icPair[0]) & 0xffff;
+    pollData.mask = Util::stringToHex(icPair[1]) & 0xff;
+    pollData.expected = Util::stringToHex(icPair[2]) & 0xff;
+    std::tie(pollData.interval, pollData.timeout) = stringToPollTiming(icPair[3], icPair[4]);
+    return std::make_pair(icOperation, pollData);
+  }
+
   // Parse IC operation
   if (icPair[icPair.size() - 1] == "lock") {
     icOperation = Ic::Operation::Lock;
@@ -494,9 +1588,9 @@ std::pair<Ic::Operation, Ic::Data> AlfServer::stringToIcPair(const std::string s
   return std::make_pair(icOperation, icData);
 }
 
-std::vector<std::vector<uint32_t>> AlfServer::parseStringToRegisterPairs(std::vector<std::string> stringPairs)
+std::vector<AlfServer::RegisterPair> AlfServer::parseStringToRegisterPairs(std::vector<std::string> stringPairs)
 {
-  std::vector<std::vector<uint32_t>> pairs;
+  std::vector<RegisterPair> pairs;
   for (const auto& stringPair : stringPairs) {
     if (stringPair.find('#') == std::string::npos) {
       pairs.push_back(stringToRegisterPair(stringPair));
@@ -520,9 +1614,14 @@ std::vector<std::pair<Swt::Operation, Swt::Data>> AlfServer::parseStringToSwtPai
 {
 
   std::vector<std::pair<Swt::Operation, Swt::Data>> pairs;
+  SwtWord::Size wordSize = swtWordSize;
   for (const auto& stringPair : stringPairs) {
     if (stringPair.find('#') == std::string::npos) {
-      pairs.push_back(stringToSwtPair(stringPair, swtWordSize));
+      pairs.push_back(stringToSwtPair(stringPair, wordSize));
+      // a size directive applies to all the words that follow
+      if (pairs.back().first == Swt::Operation::WordSize) {
+        wordSize = boost::get<SwtWord::Size>(pairs.back().second);
+      }
     }
   }
   return pairs;
@@ -540,17 +1639,105 @@ std::vector<std::pair<Ic::Operation, Ic::Data>> AlfServer::parseStringToIcPairs(
   return pairs;
 }
 
-void AlfServer::makeRpcServers(std::vector<AlfLink> links, bool sequentialRpcs)
+AlfServer::LinkMask AlfServer::parseLinkMask(const std::string& linkMask)
+{
+  static const std::map<std::string, int> coreNames = { { "sca", ScCore::ScaCore }, { "swt", ScCore::SwtCore }, { "ic", ScCore::IcCore }, { "all", ScCore::AllScCores } };
+
+  LinkMask mask;
+  for (auto entry : Util::split(linkMask, ";")) {
+    boost::trim(entry);
+    if (entry == "") {
+      continue;
+    }
+
+    auto fields = Util::split(entry, ":");
+    if (fields.size() < 2 || fields.size() > 3) {
+      BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("Invalid link mask entry, expected [serial][/endpoint]:[links]:[cores]: " + entry));
+    }
+
+    try {
+      auto card = Util::split(fields[0], "/");
+      std::pair<int, int> key = { std::stoi(card.at(0)), (card.size() > 1) ? std::stoi(card.at(1)) : -1 };
+
+      int cores = 0;
+      for (auto core : Util::split((fields.size() == 3) ? fields[2] : "all", ",")) {
+        cores |= coreNames.at(boost::trim_copy(core));
+      }
+
+      auto& links = mask[key];
+      for (auto range : Util::split(fields[1], ",")) {
+        boost::trim(range);
+        if (range == "all") {
+          for (int linkId = 0; linkId < kCruNumLinks; linkId++) {
+            links[linkId] |= cores;
+          }
+          continue;
+        }
+        auto bounds = Util::split(range, "-");
+        int first = std::stoi(bounds.at(0));
+        int last = (bounds.size() > 1) ? std::stoi(bounds.at(1)) : first;
+        for (int linkId = first; linkId <= last; linkId++) {
+          links[linkId] |= cores;
+        }
+      }
+    } catch (const std::exception& e) {
+      BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("Invalid link mask entry: " + entry));
+    }
+  }
+  return mask;
+}
+
+void AlfServer::setLinkMask(const LinkMask& linkMask)
+{
+  mLinkMask = linkMask;
+}
+
+int AlfServer::getScCores(AlfLink link)
+{
+  auto it = mLinkMask.find({ link.serialId.getSerial(), link.serialId.getEndpoint() });
+  if (it == mLinkMask.end()) {
+    it = mLinkMask.find({ link.serialId.getSerial(), -1 });
+  }
+  if (it == mLinkMask.end()) {
+    return ScCore::AllScCores;
+  }
+  auto cores = it->second.find(link.linkId);
+  return (cores != it->second.end()) ? cores->second : 0;
+}
+
+void AlfServer::makeRpcServers(std::vector<AlfLink> links, bool sequentialRpcs, int cardThreads)
 {
+  if (cardThreads > kMaxCardThreads) {
+    BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("At most " + std::to_string(kMaxCardThreads) + " DIM threads per card are supported"));
+  }
+
   for (auto& link : links) {
-    // Set a unique parallel dim rpc bank for every link
-    int parallelDimRpcBank = sequentialRpcs ? 0 : (link.serialId.getSerial() * 100) + link.rawLinkId;
+    int parallelDimRpcBank = (link.serialId.getSerial() * 100) + link.rawLinkId;
+
+    // Function to create RPC server on one of the link's execution lanes. All the services of a link share its dim rpc
+    // bank, unless cardThreads spreads the lanes of all the links of the card over that many banks. The high priority
+    // services share the bank of their lane, their priority only orders the requests waiting for the lane
+    auto makeLaneServer = [&](int lane, std::string name, auto callback, bool quotaExempt = false) {
+      int laneBank;
+      if (sequentialRpcs) {
+        laneBank = 0;
+      } else if (cardThreads > 0) {
+        int linkIndex = (link.rawLinkId >= 0) ? link.rawLinkId : link.linkId;
+        int slot = (linkIndex * (Lane::NumLanes + 1) + lane) % cardThreads;
+        laneBank = link.serialId.getSerial() * kMaxCardThreads + slot;
+      } else {
+        laneBank = parallelDimRpcBank;
+      }
+      return std::make_unique<StringRpcServer>(name, callback, laneBank, quotaExempt);
+    };
 
-    // Function to create RPC server
-    auto makeServer = [&](std::string name, auto callback) {
-      return std::make_unique<StringRpcServer>(name, callback, parallelDimRpcBank);
+    // Function to create RPC server for the services outside the SC lanes
+    auto makeServer = [&](std::string name, auto callback, bool quotaExempt = false) {
+      return makeLaneServer(Lane::NumLanes, name, callback, quotaExempt);
     };
 
+    auto linkContext = std::make_shared<LinkContext>(link);
+
     // Object for generating DNS names for the AlfLink
     ServiceNames names(link);
 
@@ -564,9 +1751,26 @@ void AlfServer::makeRpcServers(std::vector<AlfLink> links, bool sequentialRpcs)
                                         .setCardId(link.serialId);
       mSessions[link.serialId] = std::make_shared<lla::Session>(params);
 
-      if (ScaMftPsu::isAnMftPsuLink(link)) {
+      // SC cores of the link whose services are made, none for the links masked out
+      int scCores = getScCores(link);
+      linkContext->scCores = scCores;
+      linkContext->mftPsu = ScaMftPsu::isAnMftPsuLink(link);
+
+      if (scCores != 0) {
+        // Link Status
+        linkContext->linkStatusService = std::make_unique<DimService>(names.linkStatus().c_str(), linkContext->linkDown);
+
+        // Result of the last async sequence
+        linkContext->sequenceResult = toCharBuffer("");
+        linkContext->sequenceResultService = std::make_unique<DimService>(names.sequenceResult().c_str(), linkContext->sequenceResult.data());
+
+        std::lock_guard<std::mutex> lock(mLinkContextsMutex);
+        mLinkContexts[link.serialId.getSerial()][link.rawLinkId] = linkContext;
+      }
+
+      if ((scCores & ScCore::ScaCore) && linkContext->mftPsu) {
         // SCA MFT PSU Sequence
-        servers.push_back(makeServer(names.scaMftPsuSequence(),
+        servers.push_back(makeLaneServer(Lane::ScaLane, names.scaMftPsuSequence(),
                                      [link, this](auto parameter) { return scaMftPsuBlobWrite(parameter, link); }));
         continue;
       }
@@ -575,7 +1779,7 @@ void AlfServer::makeRpcServers(std::vector<AlfLink> links, bool sequentialRpcs)
 
         // Register Sequence
         servers.push_back(makeServer(names.registerSequence(),
-                                     [bar](auto parameter) { return registerBlobWrite(parameter, bar, true); }));
+                                     [bar, link, this](auto parameter) { return registerBlobWrite(parameter, bar, true, mSessions[link.serialId]); }));
         // Pattern Player
         servers.push_back(makeServer(names.patternPlayer(),
                                      [bar](auto parameter) { return patternPlayer(parameter, bar); }));
@@ -584,26 +1788,82 @@ void AlfServer::makeRpcServers(std::vector<AlfLink> links, bool sequentialRpcs)
         servers.push_back(makeServer(names.llaSessionStart(),
                                      [link, this](auto parameter) { return llaSessionStart(parameter, link.serialId); }));
 
-        // LLA Session Stop
+        // LLA Session Stop, exempt from the client quotas so that a throttled client can still release the card
         servers.push_back(makeServer(names.llaSessionStop(),
-                                     [link, this](auto parameter) { return llaSessionStop(parameter, link.serialId); }));
+                                     [link, this](auto parameter) { return llaSessionStop(parameter, link.serialId); }, true));
+
+        // LLA Lock Status
+        {
+          std::lock_guard<std::mutex> lock(mLockStatusMutex);
+          auto& cardLockStatus = mLockStatus[link.serialId.getSerial()];
+          cardLockStatus.status = toCharBuffer(lockStatus(link.serialId.getSerial()));
+          cardLockStatus.service = std::make_unique<DimService>(names.llaLockStatus().c_str(), cardLockStatus.status.data());
+        }
+
+        // Statistics
+        servers.push_back(makeServer(names.statistics(),
+                                     [link, this](auto parameter) { return statistics(parameter, link.serialId.getSerial()); }));
+
+        // Card Sequence
+        servers.push_back(makeServer(names.cardSequence(),
+                                     [link, this](auto parameter) { return cardSequence(parameter, link.serialId.getSerial()); }));
+
+        // Store Sequence
+        servers.push_back(makeServer(names.storeSequence(),
+                                     [this](auto parameter) { return storeSequenceRpc(parameter); }));
+      }
+
+      if (scCores == 0) {
+        continue;
+      }
+
+      // SCA Sequence, and high priority SCA Sequence, e.g. for monitoring
+      if (scCores & ScCore::ScaCore) {
+        servers.push_back(makeLaneServer(Lane::ScaLane, names.scaSequence(),
+                                     [link, this](auto parameter) { return scaBlobWrite(parameter, link); }));
+        servers.push_back(makeLaneServer(Lane::ScaLane, names.scaSequencePriority(),
+                                     [link, this](auto parameter) { return scaBlobWrite(parameter, link, LaneMutex::High); }));
       }
 
-      // SCA Sequence
-      servers.push_back(makeServer(names.scaSequence(),
-                                   [link, this](auto parameter) { return scaBlobWrite(parameter, link); }));
-      // SWT Sequence
-      servers.push_back(makeServer(names.swtSequence(),
-                                   [link, this](auto parameter) { return swtBlobWrite(parameter, link); }));
-      // IC Sequence
-      servers.push_back(makeServer(names.icSequence(),
-                                   [link, this](auto parameter) { return icBlobWrite(parameter, link); }));
+      // SWT Sequence, and high priority SWT Sequence
+      if (scCores & ScCore::SwtCore) {
+        servers.push_back(makeLaneServer(Lane::SwtLane, names.swtSequence(),
+                                     [link, this](auto parameter) { return swtBlobWrite(parameter, link); }));
+        servers.push_back(makeLaneServer(Lane::SwtLane, names.swtSequencePriority(),
+                                     [link, this](auto parameter) { return swtBlobWrite(parameter, link, LaneMutex::High); }));
+      }
+
+      // IC Sequence, high priority IC Sequence and IC GBT I2C write
+      if (scCores & ScCore::IcCore) {
+        servers.push_back(makeLaneServer(Lane::IcLane, names.icSequence(),
+                                     [link, this](auto parameter) { return icBlobWrite(parameter, link); }));
+        servers.push_back(makeLaneServer(Lane::IcLane, names.icSequencePriority(),
+                                     [link, this](auto parameter) { return icBlobWrite(parameter, link, LaneMutex::High); }));
+        servers.push_back(makeLaneServer(Lane::IcLane, names.icGbtI2cWrite(),
+                                     [link, this](auto parameter) { return icGbtI2cWrite(parameter, link); }));
+      }
 
-      // IC GBT I2C write
-      servers.push_back(makeServer(names.icGbtI2cWrite(),
-                                   [link, this](auto parameter) { return icGbtI2cWrite(parameter, link); }));
+      // SC Program
+      servers.push_back(makeLaneServer(Lane::AllLanes, names.scProgram(),
+                                   [link, this](auto parameter) { return scProgram(parameter, link); }));
+
+      // Stored Sequence
+      servers.push_back(makeLaneServer(Lane::AllLanes, names.storedSequence(),
+                                   [link, this](auto parameter) { return runStoredSequence(parameter, link); }));
+
+      // Async Sequence, run in the background by the workers; the lanes are locked by the sequence itself
+      servers.push_back(makeServer(names.asyncSequence(),
+                                   [link, this](auto parameter) { return asyncSequence(parameter, link); }));
+
+      // Async Result, exempt from the client quotas so that a throttled client can still collect its results
+      servers.push_back(makeServer(names.asyncResult(),
+                                   [this](auto parameter) { return asyncResult(parameter); }, true));
 
     } else if (link.cardType == roc::CardType::Crorc) {
+      if (getScCores(link) == 0) {
+        continue;
+      }
+
       // Register Sequence
       servers.push_back(makeServer(names.registerSequenceLink(),
                                    [bar](auto parameter) { return registerBlobWrite(parameter, bar); }));
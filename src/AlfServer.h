@@ -22,6 +22,8 @@
 #include <boost/algorithm/string/predicate.hpp>
 #include <chrono>
 #include <iomanip>
+#include <mutex>
+#include <shared_mutex>
 #include <thread>
 #include <unordered_set>
 
@@ -35,6 +37,11 @@
 
 #include "Lla/Lla.h"
 #include "ReadoutCard/PatternPlayer.h"
+#include "LaneMutex.h"
+#include "CostModel.h"
+#include "ScProgram.h"
+#include "SequenceOptimizer.h"
+#include "ThreadPool.h"
 
 namespace roc = AliceO2::roc;
 namespace lla = o2::lla;
@@ -47,26 +54,170 @@ namespace alf
 class AlfServer
 {
  public:
-  AlfServer(SwtWord::Size swtWordSize = SwtWord::Size::Low);
-  void makeRpcServers(std::vector<AlfLink> links, bool sequentialRpcs = false);
+  /// \param swtWordSize Default size for SWT read operations
+  /// \param workers Number of worker threads for the card sequences, 0 for the number of hardware threads
+  /// \param linkLocks Locks link-local locked sequences with per-link locks instead of the card's LLA session
+  AlfServer(SwtWord::Size swtWordSize = SwtWord::Size::Low, int workers = 0, bool linkLocks = false);
+  ~AlfServer();
+
+  /// Makes the RPC servers of the links of a card
+  /// \param sequentialRpcs Runs all RPCs of the server on a single DIM thread
+  /// \param cardThreads Number of DIM threads of the card, shared by the lanes of all its links, 0 for a
+  ///        single thread per link
+  void makeRpcServers(std::vector<AlfLink> links, bool sequentialRpcs = false, int cardThreads = 0);
+
+  /// SC cores of a link, whose services are made
+  enum ScCore { ScaCore = 1,
+                SwtCore = 2,
+                IcCore = 4,
+                AllScCores = ScaCore | SwtCore | IcCore };
+
+  /// (serial, endpoint or -1 for all endpoints) -> link -> SC cores of the link
+  typedef std::map<std::pair<int, int>, std::map<int, int>> LinkMask;
+
+  /// Parses a link mask, as `[serial][/endpoint]:[links]:[cores];...` where links and cores are comma-separated
+  /// lists, or `all`, e.g. `1041:0-3,8:sca,ic;1042/1:all`. The cores default to all of them.
+  /// \throws o2::alf::AlfException on invalid link masks
+  static LinkMask parseLinkMask(const std::string& linkMask);
+
+  /// Restricts the services made by makeRpcServers to the links of the link mask, and their SC cores. All the links
+  /// of the cards missing from the link mask get their services.
+  void setLinkMask(const LinkMask& linkMask);
+
+  /// Loads stored sequences from a directory, one sequence per file named [name].[type]
+  /// where type is one of register, sca, swt, ic or program
+  void loadSequences(const std::string& directory);
 
  private:
-  std::string scaBlobWrite(const std::string& parameter, AlfLink link);
+  /// Enum for the different register sequence operation types
+  enum RegisterOperation { Read,
+                           Write,
+                           ReadBlock,
+                           WriteBlock,
+                           ReadModifyWrite,
+                           Poll };
+
+  /// Register operation and its arguments:
+  ///   Read            -> address
+  ///   Write           -> address, value
+  ///   ReadBlock       -> address, count
+  ///   WriteBlock      -> address, values...
+  ///   ReadModifyWrite -> address, mask, value
+  ///   Poll            -> address, mask, expected value, interval, timeout
+  typedef std::pair<RegisterOperation, std::vector<uint32_t>> RegisterPair;
+
+  /// Execution lanes of a link: the SC cores use disjoint registers, so their operations run independently
+  enum Lane { ScaLane,
+              SwtLane,
+              IcLane,
+              AllLanes, // operations on all the SC cores, e.g. sc_reset
+              NumLanes };
+
+  /// Link state shared between the link services and the card sequence
+  struct LinkContext {
+    LinkContext(AlfLink link) : link(link) {}
+    AlfLink link;
+    std::array<LaneMutex, Lane::AllLanes> lanes; // serializes the SC transactions of each lane
+    std::array<LatencyStatistics, LaneMutex::NumPriorities> laneWait;
+    int linkDown = 0;                                // circuit breaker state, published by linkStatusService
+    std::unique_ptr<DimService> linkStatusService;
+    std::vector<char> sequenceResult; // outcome of the last async sequence, published by sequenceResultService
+    std::unique_ptr<DimService> sequenceResultService;
+    std::mutex sequenceResultMutex;
+    std::timed_mutex lock; // advisory lock of the link's locked sequences, with linkLocks
+    int scCores = ScCore::AllScCores; // SC cores of the link left by the link mask
+    bool mftPsu = false;               // whether the link is an MFT PSU link, read once at startup
+  };
+
+  /// Advisory lock held by a locked sequence with linkLocks: link-local sequences hold their link's lock and share
+  /// the card's, while sequences resetting the SC cores hold the card's exclusively, on top of the LLA session
+  struct AdvisoryLock {
+    std::shared_lock<std::shared_timed_mutex> sharedCard;
+    std::unique_lock<std::shared_timed_mutex> card;
+    std::unique_lock<std::timed_mutex> link;
+  };
+
+  /// Sequence running in the background, started by ASYNC_SEQUENCE
+  struct AsyncJob {
+    bool done = false;
+    bool failed = false;
+    std::string result;
+  };
+
+  /// \return The SC cores of a link whose services are made, 0 for the links masked out
+  int getScCores(AlfLink link);
+
+  /// \return The context of a link, or nullptr for links without context
+  std::shared_ptr<LinkContext> getLinkContext(AlfLink link);
+
+  /// Rejects the operations on an SC core masked out on a link, whichever service they come from
+  /// \throws o2::alf::AlfException if the core is masked out
+  void checkScCore(AlfLink link, ScCore core);
+
+  /// Locks an execution lane of a link, or all of them for Lane::AllLanes
+  /// \return The lock, or nullptr for links without lanes
+  std::unique_ptr<LaneLock> lockLanes(AlfLink link, Lane lane, LaneMutex::Priority priority = LaneMutex::Normal);
+
+  /// Takes the advisory lock of a locked sequence, to be taken before the lanes
+  /// \param card Locks the whole card, for sequences resetting the SC cores
+  /// \param timeout Timeout in ms, 0 to block
+  /// \return The lock, or nullptr for links without context
+  /// \throws o2::alf::AlfException if the lock couldn't be taken in time
+  std::unique_ptr<AdvisoryLock> lockAdvisory(AlfLink link, bool card, int timeout);
+  std::string runScProgram(const ScProgram& program, AlfLink link);
+
+  /// Parsed sequence of any of the stored sequence types
+  typedef boost::variant<std::vector<RegisterPair>,
+                         std::vector<std::pair<Sca::Operation, Sca::Data>>,
+                         std::vector<std::pair<Swt::Operation, Swt::Data>>,
+                         std::vector<std::pair<Ic::Operation, Ic::Data>>,
+                         std::shared_ptr<const ScProgram>>
+    ParsedSequence;
+
+  /// Named sequence stored on the server, with $1, $2, ... parameter placeholders
+  struct StoredSequence {
+    std::string type;
+    std::vector<std::string> lines;
+    int parameterCount;
+    /// substituted parameters -> parsed sequence, so that repeated calls are only parsed once
+    std::map<std::vector<std::string>, ParsedSequence> parsed;
+  };
+
+  std::string scaBlobWrite(const std::string& parameter, AlfLink link, LaneMutex::Priority priority = LaneMutex::Normal);
   std::string scaMftPsuBlobWrite(const std::string& parameter, AlfLink link);
-  std::string swtBlobWrite(const std::string& parameter, AlfLink link);
-  std::string icBlobWrite(const std::string& parameter, AlfLink link);
+  std::string swtBlobWrite(const std::string& parameter, AlfLink link, LaneMutex::Priority priority = LaneMutex::Normal);
+  std::string icBlobWrite(const std::string& parameter, AlfLink link, LaneMutex::Priority priority = LaneMutex::Normal);
   std::string icGbtI2cWrite(const std::string& parameter, AlfLink link);
+  std::string scProgram(const std::string& parameter, AlfLink link);
+  std::string cardSequence(const std::string& parameter, int serial);
+  std::string statistics(const std::string& parameter, int serial);
+  /// \return The contention of the LLA lock of a card, as published by its LLA_LOCK_STATUS service
+  static std::string lockStatus(int serial);
+  std::string runSection(const std::string& type, const std::vector<std::string>& lines, AlfLink link);
+  std::string asyncSequence(const std::string& parameter, AlfLink link);
+  std::string asyncResult(const std::string& parameter);
+  std::string storeSequenceRpc(const std::string& parameter);
+  std::string runStoredSequence(const std::string& parameter, AlfLink link);
+  void storeSequence(const std::string& name, const std::string& type, const std::vector<std::string>& lines);
+  ParsedSequence parseSequence(const std::string& type, const std::vector<std::string>& lines);
+  std::string executeScaSequence(std::vector<std::pair<Sca::Operation, Sca::Data>> scaPairs, AlfLink link, LaneMutex::Priority priority = LaneMutex::Normal, bool optimize = false);
+  std::string executeSwtSequence(std::vector<std::pair<Swt::Operation, Swt::Data>> swtPairs, AlfLink link, LaneMutex::Priority priority = LaneMutex::Normal, bool optimize = false);
+  std::string executeIcSequence(std::vector<std::pair<Ic::Operation, Ic::Data>> icPairs, AlfLink link, LaneMutex::Priority priority = LaneMutex::Normal, bool optimize = false);
+  static CostModel::Breakdown estimateRegisterSequence(const std::vector<RegisterPair>& registerPairs);
+  static std::string executeRegisterSequence(const std::vector<RegisterPair>& registerPairs, std::shared_ptr<roc::BarInterface>, bool isCru = false, std::shared_ptr<lla::Session> llaSession = nullptr);
   static std::string patternPlayer(const std::string& parameter, std::shared_ptr<roc::BarInterface>);
-  static std::string registerBlobWrite(const std::string& parameter, std::shared_ptr<roc::BarInterface>, bool isCru = false);
+  static std::string registerBlobWrite(const std::string& parameter, std::shared_ptr<roc::BarInterface>, bool isCru = false, std::shared_ptr<lla::Session> llaSession = nullptr);
   std::string llaSessionStart(const std::string& parameter, roc::SerialId serialId);
   std::string llaSessionStop(const std::string& parameter, roc::SerialId serialId);
   std::string resetCard(const std::string& parameter, AlfLink link);
 
-  static std::vector<uint32_t> stringToRegisterPair(const std::string stringPair);
+  static RegisterPair stringToRegisterPair(const std::string stringPair);
   static std::pair<Sca::Operation, Sca::Data> stringToScaPair(const std::string stringPair);
   static std::pair<Swt::Operation, Swt::Data> stringToSwtPair(const std::string stringPair, const SwtWord::Size swtWordSize);
   static std::pair<Ic::Operation, Ic::Data> stringToIcPair(const std::string stringPair);
-  static std::vector<std::vector<uint32_t>> parseStringToRegisterPairs(std::vector<std::string> stringPairs);
+  static SwtWord stringToSwtWord(const std::string hexString, const SwtWord::Size swtWordSize);
+  static std::pair<int, int> stringToPollTiming(const std::string interval, const std::string timeout);
+  static std::vector<RegisterPair> parseStringToRegisterPairs(std::vector<std::string> stringPairs);
   static std::vector<std::pair<Sca::Operation, Sca::Data>> parseStringToScaPairs(std::vector<std::string> stringPairs);
   static std::vector<std::pair<Swt::Operation, Swt::Data>> parseStringToSwtPairs(std::vector<std::string> stringPairs, const SwtWord::Size swtWordSize);
   static std::vector<std::pair<Ic::Operation, Ic::Data>> parseStringToIcPairs(std::vector<std::string> stringPairs);
@@ -83,6 +234,55 @@ class AlfServer
 
   // default size for SWT read operations
   SwtWord::Size mSwtWordSize;
+
+  LinkMask mLinkMask;
+
+  /// program text -> compiled SC program, so that repeated programs are only compiled once
+  std::map<std::string, std::shared_ptr<const ScProgram>> mScPrograms;
+  std::mutex mScProgramsMutex;
+  static constexpr size_t kMaxCachedScPrograms = 64;
+  static constexpr int kMaxCardThreads = 1000;
+  /// Maximum number of registers of a read_block or write_block
+  static constexpr uint64_t kMaxBlockSize = 65536;
+  /// Maximum timeout of a poll operation in ms
+  static constexpr int kMaxPollTimeout = 60000;
+  /// Minimum interval of a poll operation in ms, keeping polls from spinning on the BAR or the SC bus
+  static constexpr int kMinPollInterval = 1;
+
+  /// serial -> raw link id -> link context, for the card sequence
+  std::map<int, std::map<int, std::shared_ptr<LinkContext>>> mLinkContexts;
+  std::mutex mLinkContextsMutex;
+
+  /// Whether link-local locked sequences take the advisory locks instead of the card's LLA session
+  bool mLinkLocks;
+  /// serial -> advisory lock of the card, guarded by mLinkContextsMutex
+  std::map<int, std::shared_timed_mutex> mCardLocks;
+
+  /// LLA lock contention of a card, published by service
+  struct LockStatus {
+    std::vector<char> status;
+    std::unique_ptr<DimService> service;
+  };
+  /// serial -> LLA lock contention of the card
+  std::map<int, LockStatus> mLockStatus;
+  std::mutex mLockStatusMutex;
+
+  /// Workers running the link sections of card sequences
+  std::unique_ptr<ThreadPool> mWorkerPool;
+
+  /// job id -> async sequence, kept until evicted by newer jobs once done
+  std::map<uint64_t, AsyncJob> mAsyncJobs;
+  uint64_t mNextAsyncJobId = 1;
+  std::mutex mAsyncJobsMutex;
+  static constexpr size_t kMaxAsyncJobs = 1024;
+
+  /// name -> stored sequence
+  std::map<std::string, std::shared_ptr<StoredSequence>> mStoredSequences;
+  std::mutex mStoredSequencesMutex;
+  static constexpr size_t kMaxParsedPerStoredSequence = 16;
+  static constexpr size_t kMaxStoredSequences = 1024;
+  /// Maximum size of the body of a stored sequence, in bytes
+  static constexpr size_t kMaxStoredSequenceSize = 1 << 20;
 };
 
 } // namespace alf
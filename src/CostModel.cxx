@@ -0,0 +1,125 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file CostModel.cxx
+/// \brief Implementation of the cost model estimating the duration of sequences on a link
+
+#include <sstream>
+
+#include "Alf/ScBase.h"
+#include "CostModel.h"
+
+namespace o2
+{
+namespace alf
+{
+
+namespace
+{
+/// Latencies assumed until enough transactions have been observed on the link
+constexpr auto kNominalScaLatency = std::chrono::microseconds(50);
+constexpr auto kNominalSwtLatency = std::chrono::microseconds(100);
+constexpr auto kNominalIcLatency = std::chrono::milliseconds(10);
+
+std::chrono::microseconds medianLatency(const AlfLink& link, ScBase::TimeoutKind kind, std::chrono::microseconds nominal)
+{
+  auto latency = ScBase::getLatencyQuantile(link, kind, 0.5);
+  return (latency.count() > 0) ? latency : nominal;
+}
+
+/// Parsed waits always carry their time
+std::chrono::microseconds waitTime(const int* ms)
+{
+  return std::chrono::milliseconds(ms ? *ms : 0);
+}
+} // namespace
+
+CostModel::CostModel(const AlfLink& link)
+  : mScaLatency(medianLatency(link, ScBase::ScaTimeout, kNominalScaLatency)),
+    mSwtLatency(medianLatency(link, ScBase::SwtTimeout, kNominalSwtLatency)),
+    mIcLatency(medianLatency(link, ScBase::IcTimeout, kNominalIcLatency))
+{
+}
+
+std::chrono::microseconds CostModel::cost(const std::pair<Sca::Operation, Sca::Data>& op) const
+{
+  // A transaction writes the command and data, then waits on the busy flag twice and on the channel once
+  auto transaction = 3 * mScaLatency + 8 * kBarAccess;
+  switch (op.first) {
+    case Sca::Operation::Command:
+    case Sca::Operation::Poll: // at least one transaction
+      return transaction;
+    case Sca::Operation::ReadModifyWrite:
+      return 2 * transaction;
+    case Sca::Operation::Wait:
+      return waitTime(boost::get<Sca::WaitTime>(&op.second));
+    case Sca::Operation::SCReset:
+    case Sca::Operation::SVLReset:
+    case Sca::Operation::SVLConnect:
+      return 2 * kBarAccess;
+    default:
+      return std::chrono::microseconds(0);
+  }
+}
+
+std::chrono::microseconds CostModel::cost(const std::pair<Swt::Operation, Swt::Data>& op) const
+{
+  auto write = 3 * kBarAccess;
+  auto read = mSwtLatency + 4 * kBarAccess;
+  switch (op.first) {
+    case Swt::Operation::Write:
+      return write;
+    case Swt::Operation::Read:
+      return read;
+    case Swt::Operation::ReadMultiple: {
+      auto count = boost::get<int>(&op.second);
+      return (count ? *count : 1) * read;
+    }
+    case Swt::Operation::Poll: // at least one write and read
+      return write + read;
+    case Swt::Operation::Wait:
+      return waitTime(boost::get<Swt::WaitTime>(&op.second));
+    case Swt::Operation::SCReset:
+      return 2 * kBarAccess;
+    default:
+      return std::chrono::microseconds(0);
+  }
+}
+
+std::chrono::microseconds CostModel::cost(const std::pair<Ic::Operation, Ic::Data>& op) const
+{
+  switch (op.first) {
+    case Ic::Operation::Read:
+    case Ic::Operation::Write:
+    case Ic::Operation::Poll: // at least one read
+      return mIcLatency + 8 * kBarAccess;
+    default:
+      return std::chrono::microseconds(0);
+  }
+}
+
+std::string CostModel::format(const Breakdown& breakdown)
+{
+  std::chrono::microseconds total(0);
+  for (const auto& entry : breakdown) {
+    total += entry.second.second;
+  }
+
+  std::stringstream resultBuffer;
+  resultBuffer << "estimate_us," << total.count() << "\n";
+  for (const auto& entry : breakdown) {
+    resultBuffer << entry.first << "," << entry.second.first << "," << entry.second.second.count() << "\n";
+  }
+  return resultBuffer.str();
+}
+
+} // namespace alf
+} // namespace o2
@@ -0,0 +1,80 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file CostModel.h
+/// \brief Definition of the cost model estimating the duration of sequences on a link
+
+#ifndef O2_ALF_SRC_COSTMODEL_H_
+#define O2_ALF_SRC_COSTMODEL_H_
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Alf/Common.h"
+#include "Alf/Ic.h"
+#include "Alf/Sca.h"
+#include "Alf/Swt.h"
+
+namespace o2
+{
+namespace alf
+{
+
+/// Estimates the duration of sequences on a link without touching the hardware, from the explicit waits, the number
+/// of BAR accesses and SC transactions, and the median SC latencies observed on the link at runtime (or nominal
+/// latencies until enough transactions have been observed)
+class CostModel
+{
+ public:
+  /// Estimated durations by operation: operation name -> (count, total duration)
+  typedef std::map<std::string, std::pair<uint64_t, std::chrono::microseconds>> Breakdown;
+
+  /// Estimated duration of a BAR register access
+  static constexpr std::chrono::microseconds kBarAccess{ 1 };
+
+  CostModel(const AlfLink& link);
+
+  std::chrono::microseconds cost(const std::pair<Sca::Operation, Sca::Data>& op) const;
+  std::chrono::microseconds cost(const std::pair<Swt::Operation, Swt::Data>& op) const;
+  std::chrono::microseconds cost(const std::pair<Ic::Operation, Ic::Data>& op) const;
+
+  /// Estimates the duration of a sequence
+  /// \param sequence The sequence
+  /// \param toString Gives the name of an operation
+  /// \return The breakdown of the estimate by operation
+  template <typename Operation, typename Data, typename ToString>
+  Breakdown estimate(const std::vector<std::pair<Operation, Data>>& sequence, ToString toString) const
+  {
+    Breakdown breakdown;
+    for (const auto& op : sequence) {
+      auto& entry = breakdown[toString(op.first)];
+      entry.first++;
+      entry.second += cost(op);
+    }
+    return breakdown;
+  }
+
+  /// Formats an estimate as `estimate_us,[total]` followed by `[operation],[count],[us]` lines
+  static std::string format(const Breakdown& breakdown);
+
+ private:
+  std::chrono::microseconds mScaLatency;
+  std::chrono::microseconds mSwtLatency;
+  std::chrono::microseconds mIcLatency;
+};
+
+} // namespace alf
+} // namespace o2
+
+#endif // O2_ALF_SRC_COSTMODEL_H_
@@ -16,12 +16,16 @@
 /// \author Pascal Boeschoten (pascal.boeschoten@cern.ch)
 /// \author Kostas Alexopoulos (kostas.alexopoulos@cern.ch)
 
+#include <cmath>
+#include <map>
+#include <mutex>
 #include <string>
 
 #include "Alf/Exception.h"
 #include "boost/algorithm/string/predicate.hpp"
 #include "DimServices/DimServices.h"
 #include "Logger.h"
+#include "Util.h"
 
 #include <Common/SimpleLog.h>
 SimpleLog alfDebugLog;
@@ -99,8 +103,136 @@ inline void rtrim(std::string &s) {
     }).base(), s.end());
 }
 
+namespace
+{
+/// Quota and accounting of a DIM client
+struct ClientState {
+  double weight = 1;
+  double tokens = 0;
+  RequestClient::Clock::time_point lastUpdate;
+  uint64_t requests = 0;
+  uint64_t rejected = 0;
+  uint64_t timeUs = 0;
+  double recentRequests = 0; // decayed with kClientHalfLife
+  double recentTimeUs = 0;   // decayed with kClientHalfLife
+};
+
+constexpr double kClientHalfLife = 10.0; // s
+constexpr size_t kMaxClients = 256;
+constexpr auto kClientIdleTime = std::chrono::minutes(10);
+/// Client sharing its state with the new clients once kMaxClients are active, keeping the clients bounded
+const std::string kOverflowClient = "overflow";
+
+std::mutex clientsMutex;
+std::map<std::string, ClientState> clients;
+double clientRate = 0;
+double clientBurst = 10;
+std::vector<std::pair<std::string, double>> clientWeights;
+
+/// Gets the state of a client, with its token bucket and recent usage brought up to date
+ClientState& getClient(const std::string& name)
+{
+  auto now = RequestClient::Clock::now();
+  auto it = clients.find(name);
+  if (it == clients.end()) {
+    bool overflow = false;
+    if (clients.size() >= kMaxClients) {
+      // Forget the clients gone idle, e.g. finished scripts
+      for (auto idle = clients.begin(); idle != clients.end();) {
+        idle = (now - idle->second.lastUpdate > kClientIdleTime) ? clients.erase(idle) : std::next(idle);
+      }
+      // Too many active clients, the new ones share a single state
+      if (clients.size() >= kMaxClients) {
+        overflow = true;
+        it = clients.find(kOverflowClient);
+      }
+    }
+    if (it == clients.end()) {
+      ClientState client;
+      for (const auto& weight : clientWeights) {
+        if (!overflow && name.find(weight.first) != std::string::npos) {
+          client.weight = weight.second;
+          break;
+        }
+      }
+      client.tokens = clientBurst * client.weight;
+      client.lastUpdate = now;
+      it = clients.emplace(overflow ? kOverflowClient : name, client).first;
+    }
+  }
+
+  auto& client = it->second;
+  double elapsed = std::chrono::duration<double>(now - client.lastUpdate).count();
+  double decay = std::exp2(-elapsed / kClientHalfLife);
+  client.recentRequests *= decay;
+  client.recentTimeUs *= decay;
+  client.tokens = std::min(clientBurst * client.weight, client.tokens + elapsed * clientRate * client.weight);
+  client.lastUpdate = now;
+  return client;
+}
+} // namespace
+
+void RequestClient::configure(double rate, double burst, const std::vector<std::pair<std::string, double>>& weights)
+{
+  std::lock_guard<std::mutex> lock(clientsMutex);
+  clientRate = rate;
+  clientBurst = std::max(burst, 1.0);
+  clientWeights = weights;
+  clients.clear();
+}
+
+bool RequestClient::admit(const std::string& name)
+{
+  std::lock_guard<std::mutex> lock(clientsMutex);
+  auto& client = getClient(name);
+  if (clientRate > 0) {
+    if (client.tokens < 1) {
+      client.rejected++;
+      return false;
+    }
+    client.tokens -= 1;
+  }
+  client.requests++;
+  client.recentRequests += 1;
+  return true;
+}
+
+void RequestClient::consume(const std::string& name, Clock::duration duration)
+{
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+  std::lock_guard<std::mutex> lock(clientsMutex);
+  auto& client = getClient(name);
+  client.timeUs += us;
+  client.recentTimeUs += us;
+}
+
+double RequestClient::virtualTime()
+{
+  if (sName.empty()) {
+    return 0;
+  }
+  std::lock_guard<std::mutex> lock(clientsMutex);
+  auto& client = getClient(sName);
+  return client.recentTimeUs / client.weight;
+}
+
+std::vector<RequestClient::Statistics> RequestClient::statistics()
+{
+  std::lock_guard<std::mutex> lock(clientsMutex);
+  std::vector<Statistics> result;
+  for (const auto& it : clients) {
+    auto& client = getClient(it.first);
+    // The decayed request count settles at rate * half-life / ln(2)
+    result.push_back({ it.first, client.requests, client.rejected, client.recentRequests * std::log(2.0) / kClientHalfLife, client.timeUs });
+  }
+  return result;
+}
+
 void StringRpcServer::rpcHandler()
 {
+  // The default deadline runs from the reception of the request, the earliest point DimRpcParallel hands it over
+  auto received = RequestDeadline::Clock::now();
+
   // build a safe string from DIM input. Parent method getString() is unsafe, not guarateed to be nul-terminated
   std::string inputString;
   {
@@ -112,18 +244,57 @@ void StringRpcServer::rpcHandler()
   }
 
   alfDebugLog.info("Request received on %s (%d bytes) :\n%s",mServiceName.c_str(), (int)getSize(), inputString.c_str());
-  try {
-    auto returnValue = mCallback(inputString);
-    setDataString(makeSuccessString(returnValue), *this);
-    rtrim(returnValue);
-    alfDebugLog.info("Request completed: %s", returnValue.c_str());
-  } catch (const std::exception& e) {
-    if (kDebugLogging) {
-      Logger::get() << mServiceName << ": " << e.what() << LogErrorDevel_(5100) << endm;
+
+  // Optional deadline directive leading the request, as unix time in ms: "[deadline],deadline"
+  RequestDeadline::inFlight++;
+  size_t firstLineEnd = inputString.find(argumentSeparator());
+  std::vector<std::string> directive = Util::split(inputString.substr(0, firstLineEnd), pairSeparator());
+  if (directive.size() == 2 && boost::trim_copy(directive[1]) == "deadline") {
+    try {
+      auto deadline = std::chrono::system_clock::time_point(std::chrono::milliseconds(std::stoull(directive[0])));
+      RequestDeadline::set(RequestDeadline::Clock::now() + (deadline - std::chrono::system_clock::now()));
+    } catch (const std::exception& e) {
+      setDataString(makeFailureString("Invalid deadline directive: " + inputString.substr(0, firstLineEnd)), *this);
+      RequestDeadline::inFlight--;
+      return;
     }
-    setDataString(makeFailureString(e.what()), *this);
-    alfDebugLog.error("Request failure: %s", e.what());
+    inputString = (firstLineEnd == std::string::npos) ? "" : inputString.substr(firstLineEnd + 1);
+  } else if (RequestDeadline::defaultTimeout > 0) {
+    RequestDeadline::set(received + std::chrono::milliseconds(RequestDeadline::defaultTimeout));
   }
+
+  auto clientName = DimServer::getClientName();
+  RequestClient::set(clientName ? std::string(clientName) : std::to_string(DimServer::getClientId()));
+
+  if (!mQuotaExempt && !RequestClient::admit(RequestClient::get())) {
+    // Keep a client over its quota from monopolizing the card
+    setDataString(makeFailureString("Request quota exceeded by client " + RequestClient::get()), *this);
+    alfDebugLog.error("Request rejected: quota exceeded by client %s", RequestClient::get().c_str());
+  } else if (RequestDeadline::isExpired()) {
+    // The client has given up on this request already, don't delay the others by executing it
+    RequestDeadline::shed++;
+    setDataString(makeFailureString("Request deadline exceeded before execution"), *this);
+    alfDebugLog.error("Request shed: deadline exceeded before execution");
+  } else {
+    auto start = RequestClient::Clock::now();
+    try {
+      auto returnValue = mCallback(inputString);
+      setDataString(makeSuccessString(returnValue), *this);
+      rtrim(returnValue);
+      alfDebugLog.info("Request completed: %s", returnValue.c_str());
+    } catch (const std::exception& e) {
+      if (kDebugLogging) {
+        Logger::get() << mServiceName << ": " << e.what() << LogErrorDevel_(5100) << endm;
+      }
+      setDataString(makeFailureString(e.what()), *this);
+      alfDebugLog.error("Request failure: %s", e.what());
+    }
+    RequestClient::consume(RequestClient::get(), RequestClient::Clock::now() - start);
+  }
+
+  RequestClient::set("");
+  RequestDeadline::clear();
+  RequestDeadline::inFlight--;
 }
 
 } // namespace alf
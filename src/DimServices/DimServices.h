@@ -21,10 +21,13 @@
 
 #include <boost/exception/diagnostic_information.hpp>
 #include <boost/variant.hpp>
+#include <atomic>
+#include <chrono>
 #include <dim/dic.hxx>
 #include <dim/dim.hxx>
 #include <dim/dis.hxx>
 #include <string>
+#include <vector>
 
 #include <DimRpcParallel/dimrpcparallel.h>
 
@@ -67,13 +70,130 @@ bool isFailure(const std::string& str);
 std::string stripPrefix(const std::string& str);
 
 // SERVER
+
+/// Deadline of the request handled by the current thread, and the server-wide admission counters
+class RequestDeadline
+{
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  static void set(Clock::time_point deadline)
+  {
+    sDeadline = deadline;
+    sIsSet = true;
+  }
+
+  static void clear()
+  {
+    sIsSet = false;
+  }
+
+  static bool isSet()
+  {
+    return sIsSet;
+  }
+
+  static Clock::time_point get()
+  {
+    return sDeadline;
+  }
+
+  static bool isExpired()
+  {
+    return sIsSet && Clock::now() > sDeadline;
+  }
+
+  /// Fails the current request before its execution if its deadline has passed, e.g. while waiting for its lanes
+  /// \throws o2::alf::AlfException if the deadline has passed
+  static void shedIfExpired()
+  {
+    if (isExpired()) {
+      shed++;
+      BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("Request deadline exceeded before execution"));
+    }
+  }
+
+  /// Aborts the current request if its deadline has passed
+  /// \throws o2::alf::AlfException if the deadline has passed
+  static void check()
+  {
+    if (isExpired()) {
+      aborted++;
+      BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("Request deadline exceeded during execution"));
+    }
+  }
+
+  /// Time in ms allowed to requests without a deadline directive, 0 for unlimited
+  inline static std::atomic<int> defaultTimeout{ 0 };
+  /// Requests being handled
+  inline static std::atomic<uint64_t> inFlight{ 0 };
+  /// Requests failed before execution, as their deadline had passed
+  inline static std::atomic<uint64_t> shed{ 0 };
+  /// Requests aborted during execution, as their deadline passed
+  inline static std::atomic<uint64_t> aborted{ 0 };
+
+ private:
+  inline static thread_local bool sIsSet = false;
+  inline static thread_local Clock::time_point sDeadline;
+};
+
+/// DIM client of the request handled by the current thread, and the per-client quotas and accounting
+class RequestClient
+{
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  /// Per-client accounting, as published by the STATISTICS RPC
+  struct Statistics {
+    std::string name;
+    uint64_t requests;
+    uint64_t rejected;
+    double rate;     ///< Requests per second, averaged over the last seconds
+    uint64_t timeUs; ///< Time consumed by the handling of the client's requests
+  };
+
+  static void set(const std::string& name)
+  {
+    sName = name;
+  }
+
+  static const std::string& get()
+  {
+    return sName;
+  }
+
+  /// Configures the per-client token bucket quotas and the weights of the fair queueing
+  /// \param rate Requests per second allowed to a client of weight 1, 0 for unlimited
+  /// \param burst Requests a client of weight 1 may issue at once above its rate
+  /// \param weights Weights of the clients whose name contains the given strings, 1 for the others
+  static void configure(double rate, double burst, const std::vector<std::pair<std::string, double>>& weights);
+
+  /// Takes a token from the bucket of a client
+  /// \return false if the client has exceeded its quota
+  static bool admit(const std::string& name);
+
+  /// Accounts the time consumed by the handling of a request of a client
+  static void consume(const std::string& name, Clock::duration duration);
+
+  /// \return The recently consumed time of the current client over its weight, ordering its requests in the fair
+  ///         queues of the execution lanes
+  static double virtualTime();
+
+  static std::vector<Statistics> statistics();
+
+ private:
+  inline static thread_local std::string sName;
+};
+
 class StringRpcServer : public DimRpcParallel
 {
  public:
   using Callback = std::function<std::string(const std::string&)>;
 
-  StringRpcServer(const std::string& serviceName, Callback callback, int bank)
-    : DimRpcParallel(serviceName.c_str(), "C", "C", bank), mCallback(callback), mServiceName(serviceName)
+  /// \param quotaExempt Whether the requests bypass the client quotas, for the services releasing resources or
+  ///        fetching results, which a client over its quota must still be able to call
+  StringRpcServer(const std::string& serviceName, Callback callback, int bank, bool quotaExempt = false)
+    : DimRpcParallel(serviceName.c_str(), "C", "C", bank), mCallback(callback), mServiceName(serviceName), mQuotaExempt(quotaExempt)
   {
   }
 
@@ -85,6 +205,7 @@ class StringRpcServer : public DimRpcParallel
 
   Callback mCallback;
   std::string mServiceName;
+  bool mQuotaExempt;
 };
 
 // CLIENT
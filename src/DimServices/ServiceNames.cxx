@@ -40,14 +40,27 @@ namespace alf
 DEFCARDSERVICENAME(patternPlayer, "PATTERN_PLAYER")
 DEFCARDSERVICENAME(llaSessionStart, "LLA_SESSION_START")
 DEFCARDSERVICENAME(llaSessionStop, "LLA_SESSION_STOP")
+DEFCARDSERVICENAME(llaLockStatus, "LLA_LOCK_STATUS")
 DEFCARDSERVICENAME(registerSequence, "REGISTER_SEQUENCE")
+DEFCARDSERVICENAME(storeSequence, "STORE_SEQUENCE")
+DEFCARDSERVICENAME(cardSequence, "CARD_SEQUENCE")
+DEFCARDSERVICENAME(statistics, "STATISTICS")
 
 DEFLINKSERVICENAME(registerSequenceLink, "REGISTER_SEQUENCE")
 DEFLINKSERVICENAME(scaSequence, "SCA_SEQUENCE")
+DEFLINKSERVICENAME(scaSequencePriority, "SCA_SEQUENCE_PRIORITY")
 DEFLINKSERVICENAME(scaMftPsuSequence, "SCA_MFT_PSU_SEQUENCE")
 DEFLINKSERVICENAME(swtSequence, "SWT_SEQUENCE")
+DEFLINKSERVICENAME(swtSequencePriority, "SWT_SEQUENCE_PRIORITY")
 DEFLINKSERVICENAME(icSequence, "IC_SEQUENCE")
+DEFLINKSERVICENAME(icSequencePriority, "IC_SEQUENCE_PRIORITY")
 DEFLINKSERVICENAME(icGbtI2cWrite, "IC_GBT_I2C_WRITE")
+DEFLINKSERVICENAME(scProgram, "SC_PROGRAM")
+DEFLINKSERVICENAME(storedSequence, "STORED_SEQUENCE")
+DEFLINKSERVICENAME(linkStatus, "LINK_STATUS")
+DEFLINKSERVICENAME(asyncSequence, "ASYNC_SEQUENCE")
+DEFLINKSERVICENAME(asyncResult, "ASYNC_RESULT")
+DEFLINKSERVICENAME(sequenceResult, "SEQUENCE_RESULT")
 DEFLINKSERVICENAME(resetCard, "RESET_CARD")
 
 std::string ServiceNames::formatLink(std::string name) const
@@ -36,15 +36,28 @@ class ServiceNames
   }
 
   std::string scaSequence() const;
+  std::string scaSequencePriority() const;
   std::string scaMftPsuSequence() const;
   std::string swtSequence() const;
+  std::string swtSequencePriority() const;
   std::string icSequence() const;
+  std::string icSequencePriority() const;
   std::string icGbtI2cWrite() const;
+  std::string scProgram() const;
+  std::string storedSequence() const;
+  std::string linkStatus() const;
+  std::string asyncSequence() const;
+  std::string asyncResult() const;
+  std::string sequenceResult() const;
   std::string patternPlayer() const;
   std::string registerSequence() const;
   std::string registerSequenceLink() const;
   std::string llaSessionStart() const;
   std::string llaSessionStop() const;
+  std::string llaLockStatus() const;
+  std::string storeSequence() const;
+  std::string cardSequence() const;
+  std::string statistics() const;
   std::string resetCard() const;
 
  private:
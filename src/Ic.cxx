@@ -78,6 +78,34 @@ Ic::Ic(std::string cardId, int linkId)
   barWrite(sc_regs::IC_WR_CFG.index, 0x3);
 }
 
+bool Ic::waitOnCompletion()
+{
+  auto isComplete = [&]() {
+    // Read the status of the FIFO
+    uint32_t ret = barRead(sc_regs::IC_RD_DATA.index);
+    uint32_t empty = (ret >> 16) & 0x1;
+    uint32_t ready = (ret >> 31) & 0x1;
+    return empty == 0x0 && ready == 0x1;
+  };
+  auto start = std::chrono::steady_clock::now();
+  bool complete = Util::waitUntil(isComplete, start + getTimeout(IcTimeout));
+  recordLatency(IcTimeout, std::chrono::steady_clock::now() - start);
+  return complete;
+}
+
+void Ic::drainFifo()
+{
+  for (int i = 0; i < kMaxFifoDrain; i++) {
+    uint32_t empty = (barRead(sc_regs::IC_RD_DATA.index) >> 16) & 0x1;
+    if (empty == 0x1) {
+      return;
+    }
+    // Pulse the READ
+    barWrite(sc_regs::IC_WR_CMD.index, 0x2);
+    barWrite(sc_regs::IC_WR_CMD.index, 0x0);
+  }
+}
+
 uint32_t Ic::read(uint32_t address)
 {
   checkChannelSet();
@@ -87,6 +115,8 @@ uint32_t Ic::read(uint32_t address)
 
   data = data + address;
 
+  drainFifo();
+
   // Write to the FIFO
   barWrite(sc_regs::IC_WR_DATA.index, data);
   barWrite(sc_regs::IC_WR_CMD.index, 0x1);
@@ -96,7 +126,11 @@ uint32_t Ic::read(uint32_t address)
   barWrite(sc_regs::IC_WR_CMD.index, 0x8);
   barWrite(sc_regs::IC_WR_CMD.index, 0x0);
 
-  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  if (!waitOnCompletion()) {
+    recordLinkTimeout();
+    BOOST_THROW_EXCEPTION(IcException() << ErrorInfo::Message("IC READ was unsuccesful"));
+  }
+  recordLinkSuccess();
 
   // Pulse the READ
   barWrite(sc_regs::IC_WR_CMD.index, 0x2);
@@ -122,6 +156,8 @@ uint32_t Ic::write(uint32_t address, uint32_t data)
 
   data += address;
 
+  drainFifo();
+
   // Write to the FIFO
   barWrite(sc_regs::IC_WR_DATA.index, data);
   barWrite(sc_regs::IC_WR_CMD.index, 0x1);
@@ -131,21 +167,33 @@ uint32_t Ic::write(uint32_t address, uint32_t data)
   barWrite(sc_regs::IC_WR_CMD.index, 0x4);
   barWrite(sc_regs::IC_WR_CMD.index, 0x0);
 
-  std::this_thread::sleep_for(std::chrono::milliseconds(10));
-
-  // Read the status of the FIFO
-  uint32_t ret = barRead(sc_regs::IC_RD_DATA.index);
-  //uint32_t gbtAddress = (ret >> 8) & 0xff;
-  //uint32_t retData = ret & 0xff;
-  uint32_t empty = (ret >> 16) & 0x1;
-  uint32_t ready = (ret >> 31) & 0x1;
-
-  if (empty != 0x0 || ready != 0x1) {
+  if (!waitOnCompletion()) {
+    recordLinkTimeout();
     BOOST_THROW_EXCEPTION(IcException() << ErrorInfo::Message("IC WRITE was unsuccesful"));
   }
+  recordLinkSuccess();
+
+  // Pop the reply, which would otherwise complete the next transaction straight away
+  barWrite(sc_regs::IC_WR_CMD.index, 0x2);
+  barWrite(sc_regs::IC_WR_CMD.index, 0x0);
+
   return echo;
 }
 
+Ic::PollData Ic::poll(PollData pollData)
+{
+  auto isDone = [&]() {
+    pollData.value = read(pollData.address);
+    return (pollData.value & pollData.mask) == (pollData.expected & pollData.mask);
+  };
+
+  if (!Util::pollUntil(isDone, pollData.interval, pollData.timeout, pollData.elapsed, [this]() { runOperationCallback(); })) {
+    BOOST_THROW_EXCEPTION(IcException() << ErrorInfo::Message(
+                            (boost::format("Poll timeout after %d ms, last value=0x%08x") % pollData.elapsed % pollData.value).str()));
+  }
+  return pollData;
+}
+
 void Ic::writeGbtI2c(uint32_t data)
 {
   barWrite(sc_regs::IC_WR_CFG.index, data);
@@ -153,6 +201,8 @@ void Ic::writeGbtI2c(uint32_t data)
 
 std::vector<std::pair<Ic::Operation, Ic::Data>> Ic::executeSequence(std::vector<std::pair<Operation, Data>> ops, bool lock)
 {
+  checkLinkUp();
+
   if (lock) {
     mLlaSession->start();
   }
@@ -167,6 +217,7 @@ std::vector<std::pair<Ic::Operation, Ic::Data>> Ic::executeSequence(std::vector<
 
   std::vector<std::pair<Ic::Operation, Ic::Data>> ret;
   for (const auto& it : ops) {
+    runOperationCallback();
     Operation operation = it.first;
     Data data = it.second;
     try {
@@ -176,14 +227,23 @@ std::vector<std::pair<Ic::Operation, Ic::Data>> Ic::executeSequence(std::vector<
       } else if (operation == Operation::Write) {
         write(boost::get<IcData>(data));
         ret.push_back({ operation, IcData{ boost::get<IcData>(data) } });
+      } else if (operation == Operation::Poll) {
+        auto out = poll(boost::get<PollData>(data));
+        ret.push_back({ operation, out });
       } else {
         BOOST_THROW_EXCEPTION(IcException() << ErrorInfo::Message("IC operation type unknown"));
       }
     } catch (const IcException& e) {
       // If an IC error occurs, we stop executing the sequence of commands and return the results as far as we got them, plus
       // the error message.
-      IcData icData = boost::get<IcData>(data);
-      std::string meaningfulMessage = (boost::format("sc_regs::IC_SEQUENCE address=0x%08x data=0x%08x serialId=%s link=%d, error='%s'") % icData.address % icData.data % mLink.serialId % mLink.linkId % e.what()).str();
+      std::string meaningfulMessage;
+      if (operation == Operation::Poll) {
+        PollData pollData = boost::get<PollData>(data);
+        meaningfulMessage = (boost::format("sc_regs::IC_SEQUENCE POLL address=0x%08x mask=0x%08x expected=0x%08x serialId=%s link=%d, error='%s'") % pollData.address % pollData.mask % pollData.expected % mLink.serialId % mLink.linkId % e.what()).str();
+      } else {
+        IcData icData = boost::get<IcData>(data);
+        meaningfulMessage = (boost::format("sc_regs::IC_SEQUENCE address=0x%08x data=0x%08x serialId=%s link=%d, error='%s'") % icData.address % icData.data % mLink.serialId % mLink.linkId % e.what()).str();
+      }
       //Logger::get().err() << meaningfulMessage << endm;
 
       ret.push_back({ Operation::Error, meaningfulMessage });
@@ -192,16 +252,20 @@ std::vector<std::pair<Ic::Operation, Ic::Data>> Ic::executeSequence(std::vector<
   }
 
   if (lock) {
-    mLlaSession->stop();
+    mLlaSession->stop(true);
   }
 
   return ret;
 }
 
 std::string Ic::writeSequence(std::vector<std::pair<Operation, Data>> ops, bool lock)
+{
+  return formatSequenceOutput(executeSequence(ops, lock));
+}
+
+std::string Ic::formatSequenceOutput(const std::vector<std::pair<Operation, Data>>& out)
 {
   std::stringstream resultBuffer;
-  auto out = executeSequence(ops, lock);
   for (const auto& it : out) {
     Operation operation = it.first;
     Data data = it.second;
@@ -209,6 +273,9 @@ std::string Ic::writeSequence(std::vector<std::pair<Operation, Data>> ops, bool
       resultBuffer << Util::formatValue(boost::get<IcOut>(data)) << "\n";
     } else if (operation == Operation::Write) {
       resultBuffer << Util::formatValue(boost::get<IcData>(data).data) << "\n";
+    } else if (operation == Operation::Poll) {
+      auto pollData = boost::get<PollData>(data);
+      resultBuffer << Util::formatValue(pollData.value) << "," << std::dec << pollData.elapsed << "\n";
     } else if (operation == Operation::Error) {
       std::string errMessage = boost::get<std::string>(data);
       resultBuffer << errMessage;
@@ -232,6 +299,8 @@ std::string Ic::IcOperationToString(Ic::Operation op)
     return "error";
   } else if (op == Ic::Operation::Lock) {
     return "lock";
+  } else if (op == Ic::Operation::Poll) {
+    return "poll";
   }
 
   BOOST_THROW_EXCEPTION(IcException() << ErrorInfo::Message("Cannot convert Ic operation to string"));
@@ -247,6 +316,8 @@ Ic::Operation Ic::StringToIcOperation(std::string op)
     return Ic::Operation::Error;
   } else if (op == "lock") {
     return Ic::Operation::Lock;
+  } else if (op == "poll") {
+    return Ic::Operation::Poll;
   }
 
   BOOST_THROW_EXCEPTION(IcException() << ErrorInfo::Message("Cannot convert IC operation to string " + op));
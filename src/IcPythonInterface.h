@@ -240,6 +240,12 @@ struct IcDataToPython {
       return bp::incref(bp::object(ret).ptr());
     }
 
+    auto operator()(Ic::PollData data) const
+    {
+      bp::tuple ret = bp::make_tuple(data.value, data.elapsed);
+      return bp::incref(bp::object(ret).ptr());
+    }
+
     auto operator()(int data) const
     {
       return bp::incref(bp::object(data).ptr());
@@ -0,0 +1,176 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file LaneMutex.h
+/// \brief Definition of the priority-aware mutex of the execution lanes of the ALF server
+
+#ifndef O2_ALF_SRC_LANEMUTEX_H_
+#define O2_ALF_SRC_LANEMUTEX_H_
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <vector>
+
+namespace o2
+{
+namespace alf
+{
+
+/// Mutex of an execution lane, where high priority requests go before the waiting normal priority ones.
+/// Requests of the same priority are served in order of the virtual time of their clients, i.e. their recently
+/// consumed time over their weight, and in arrival order for equal virtual times.
+class LaneMutex
+{
+ public:
+  enum Priority { Normal,
+                  High,
+                  NumPriorities };
+
+  void lock(Priority priority, double virtualTime = 0)
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    auto waiter = mWaiters.insert(mWaiters.end(), { priority, virtualTime, mNextSequence++ });
+    mCondition.wait(lock, [&] { return !mLocked && isNext(*waiter); });
+    mWaiters.erase(waiter);
+    mLocked = true;
+  }
+
+  void unlock()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mLocked = false;
+    }
+    mCondition.notify_all();
+  }
+
+  /// \return The number of requests waiting for the lane
+  int waiting()
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mWaiters.size();
+  }
+
+  /// \return true if high priority requests are waiting for the lane
+  bool hasHighPriorityWaiting()
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return std::any_of(mWaiters.begin(), mWaiters.end(), [](const Waiter& waiter) { return waiter.priority == High; });
+  }
+
+ private:
+  struct Waiter {
+    Priority priority;
+    double virtualTime;
+    uint64_t sequence;
+  };
+
+  static bool goesBefore(const Waiter& a, const Waiter& b)
+  {
+    if (a.priority != b.priority) {
+      return a.priority > b.priority;
+    }
+    if (a.virtualTime != b.virtualTime) {
+      return a.virtualTime < b.virtualTime;
+    }
+    return a.sequence < b.sequence;
+  }
+
+  bool isNext(const Waiter& waiter)
+  {
+    return std::none_of(mWaiters.begin(), mWaiters.end(), [&](const Waiter& other) { return goesBefore(other, waiter); });
+  }
+
+  std::mutex mMutex;
+  std::condition_variable mCondition;
+  bool mLocked = false;
+  std::list<Waiter> mWaiters;
+  uint64_t mNextSequence = 0;
+};
+
+/// Latency statistics of the requests of one priority
+class LatencyStatistics
+{
+ public:
+  void add(std::chrono::microseconds latency)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCount++;
+    mTotal += latency.count();
+    mMax = std::max(mMax, (uint64_t)latency.count());
+  }
+
+  /// \return count, average and maximum latency in us
+  std::array<uint64_t, 3> get()
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return { mCount, mCount ? mTotal / mCount : 0, mMax };
+  }
+
+ private:
+  std::mutex mMutex;
+  uint64_t mCount = 0;
+  uint64_t mTotal = 0;
+  uint64_t mMax = 0;
+};
+
+/// Holds one or more lane mutexes, locked in the given order, for the lifetime of the object
+class LaneLock
+{
+ public:
+  LaneLock(std::vector<LaneMutex*> mutexes, LaneMutex::Priority priority, double virtualTime = 0)
+    : mMutexes(mutexes), mPriority(priority), mVirtualTime(virtualTime)
+  {
+    for (auto mutex : mMutexes) {
+      mutex->lock(mPriority, mVirtualTime);
+    }
+  }
+
+  ~LaneLock()
+  {
+    for (auto it = mMutexes.rbegin(); it != mMutexes.rend(); it++) {
+      (*it)->unlock();
+    }
+  }
+
+  LaneLock(const LaneLock&) = delete;
+  LaneLock& operator=(const LaneLock&) = delete;
+
+  /// Lets waiting high priority requests run, by releasing all the held lanes and taking them back after them.
+  /// All lanes are released so that a request waiting for several of them can't deadlock with the yielding holder.
+  void yield()
+  {
+    if (mPriority == LaneMutex::High ||
+        std::none_of(mMutexes.begin(), mMutexes.end(), [](LaneMutex* mutex) { return mutex->hasHighPriorityWaiting(); })) {
+      return;
+    }
+    for (auto it = mMutexes.rbegin(); it != mMutexes.rend(); it++) {
+      (*it)->unlock();
+    }
+    for (auto mutex : mMutexes) {
+      mutex->lock(mPriority, mVirtualTime);
+    }
+  }
+
+ private:
+  std::vector<LaneMutex*> mMutexes;
+  LaneMutex::Priority mPriority;
+  double mVirtualTime;
+};
+
+} // namespace alf
+} // namespace o2
+
+#endif // O2_ALF_SRC_LANEMUTEX_H_
@@ -15,15 +15,180 @@
 ///
 /// \author Kostas Alexopoulos (kostas.alexopoulos@cern.ch)
 
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
 #include "Alf/Lla.h"
+#include "DimServices/DimServices.h"
+
+#include <Common/SimpleLog.h>
+extern SimpleLog alfDebugLog;
 
 namespace o2
 {
 namespace alf
 {
 
-LlaSession::LlaSession(std::shared_ptr<lla::Session> llaSession)
-  : mSession(llaSession)
+namespace
+{
+std::mutex lockStatisticsMutex;
+std::map<int, LlaLockStatistics> lockStatistics; // serial -> statistics
+std::function<void(int)> lockCallback;
+
+int lockBucket(std::chrono::steady_clock::duration duration)
+{
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+  int bucket = 0;
+  for (int64_t bound = 10; bucket < LlaLockStatistics::kNumBuckets - 1 && us >= bound; bound *= 10) {
+    bucket++;
+  }
+  return bucket;
+}
+
+void notifyLock(int serial)
+{
+  std::function<void(int)> callback;
+  {
+    std::lock_guard<std::mutex> lock(lockStatisticsMutex);
+    callback = lockCallback;
+  }
+  if (callback) {
+    callback(serial);
+  }
+}
+
+void recordAcquisition(int serial, std::chrono::steady_clock::duration wait)
+{
+  std::string holder = RequestClient::get().empty() ? "ALF" : RequestClient::get();
+  {
+    std::lock_guard<std::mutex> lock(lockStatisticsMutex);
+    auto& statistics = lockStatistics[serial];
+    statistics.wait[lockBucket(wait)]++;
+    statistics.acquisitions++;
+    statistics.holder = holder;
+    statistics.heldSince = std::chrono::steady_clock::now();
+  }
+  alfDebugLog.info("LLA lock of card %d taken by %s after %lld us", serial, holder.c_str(),
+                   (long long)std::chrono::duration_cast<std::chrono::microseconds>(wait).count());
+  notifyLock(serial);
+}
+
+void recordFailure(int serial, std::chrono::steady_clock::duration wait)
+{
+  std::string holder;
+  {
+    std::lock_guard<std::mutex> lock(lockStatisticsMutex);
+    auto& statistics = lockStatistics[serial];
+    statistics.failures++;
+    holder = statistics.holder;
+  }
+  // The holder is only known when the lock was taken through ALF
+  alfDebugLog.error("LLA lock of card %d not taken after %lld us, held by %s", serial,
+                    (long long)std::chrono::duration_cast<std::chrono::microseconds>(wait).count(),
+                    holder.empty() ? "another process" : holder.c_str());
+  notifyLock(serial);
+}
+
+void recordRelease(int serial)
+{
+  std::string holder;
+  std::chrono::steady_clock::duration hold;
+  {
+    std::lock_guard<std::mutex> lock(lockStatisticsMutex);
+    auto it = lockStatistics.find(serial);
+    if (it == lockStatistics.end() || it->second.holder.empty()) {
+      return;
+    }
+    hold = std::chrono::steady_clock::now() - it->second.heldSince;
+    it->second.hold[lockBucket(hold)]++;
+    holder.swap(it->second.holder);
+  }
+  alfDebugLog.info("LLA lock of card %d released by %s after %lld us", serial, holder.c_str(),
+                   (long long)std::chrono::duration_cast<std::chrono::microseconds>(hold).count());
+  notifyLock(serial);
+}
+
+/// Sessions held by leases after a locked sequence, released by a reaper thread once their idle window elapses
+class Leases
+{
+ public:
+  struct Lease {
+    std::shared_ptr<lla::Session> session;
+    int serial;
+    std::string client;
+    std::chrono::steady_clock::time_point expiry;
+    bool inUse; ///< Taken back by a locked sequence of the client
+  };
+
+  ~Leases()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    condition.notify_all();
+    if (reaper.joinable()) {
+      reaper.join();
+    }
+    for (auto& entry : leases) {
+      entry.second.session->stop();
+    }
+  }
+
+  /// Starts the reaper thread, unless already started. Must be called with the mutex locked.
+  void startReaper()
+  {
+    if (!reaper.joinable()) {
+      reaper = std::thread(&Leases::reap, this);
+    }
+  }
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::map<lla::Session*, Lease> leases;
+  std::chrono::milliseconds idleWindow{ 0 };
+
+ private:
+  void reap()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+      auto next = leases.end();
+      for (auto it = leases.begin(); it != leases.end(); it++) {
+        if (!it->second.inUse && (next == leases.end() || it->second.expiry < next->second.expiry)) {
+          next = it;
+        }
+      }
+
+      if (next == leases.end()) {
+        condition.wait(lock);
+      } else if (next->second.expiry <= std::chrono::steady_clock::now()) {
+        next->second.session->stop();
+        recordRelease(next->second.serial);
+        leases.erase(next);
+        LlaLeaseStatistics::expired++;
+      } else {
+        condition.wait_until(lock, next->second.expiry);
+      }
+    }
+  }
+
+  std::thread reaper;
+  bool stopping = false;
+};
+
+Leases& leases()
+{
+  static Leases leases;
+  return leases;
+}
+} // namespace
+
+LlaSession::LlaSession(std::shared_ptr<lla::Session> llaSession, roc::SerialId serialId)
+  : mSession(llaSession),
+    mSerialId(serialId)
 {
 }
 
@@ -35,31 +200,113 @@ LlaSession::LlaSession(std::string sessionName, roc::SerialId serialId)
 
 /* The LlaSession object goes out of scope when the last shared_ptr instance is destroyed (See AlfServer.h).
    Since said destruction may follow an erroneous event and the session might not be explicitly stopped
-   it is forcefully stopped it in the destructor */
+   it is forcefully stopped it in the destructor, if this object started it. A session started by someone else
+   (a locked sequence, a client through LLA_SESSION_START, a lease) is left alone */
 LlaSession::~LlaSession()
 {
-  stop();
+  if (!mSession || mDetached || !mHeld) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(leases().mutex);
+  leases().leases.erase(mSession.get());
+  mSession->stop();
+  recordRelease(mSerialId.getSerial());
 }
 
-void LlaSession::start(int timeout)
+bool LlaSession::start(int timeout)
 {
   if (!mSession) {
     mParams = lla::SessionParameters::makeParameters(mSessionName, mSerialId);
     mSession = std::make_shared<lla::Session>(mParams);
   }
 
+  {
+    std::lock_guard<std::mutex> lock(leases().mutex);
+    auto it = leases().leases.find(mSession.get());
+    if (it != leases().leases.end() && !it->second.inUse) {
+      if (it->second.client == RequestClient::get() && mSession->isStarted()) {
+        it->second.inUse = true;
+        mHeld = true;
+        LlaLeaseStatistics::reused++;
+        return true;
+      }
+
+      // Another client needs the session, release the lease early
+      mSession->stop();
+      recordRelease(mSerialId.getSerial());
+      leases().leases.erase(it);
+      LlaLeaseStatistics::preempted++;
+    }
+  }
+
   if (!mSession->isStarted()) {
+    auto waitStart = std::chrono::steady_clock::now();
     bool started = (timeout==0) ? mSession->start() : mSession->timedStart(timeout);
+    auto wait = std::chrono::steady_clock::now() - waitStart;
     if (!started) {
+      recordFailure(mSerialId.getSerial(), wait);
       BOOST_THROW_EXCEPTION(lla::LlaException()
                             << lla::ErrorInfo::Message("Couldn't start session")); // couldn't grab the lock
     }
+    recordAcquisition(mSerialId.getSerial(), wait);
+    mHeld = true;
+    return true;
   }
+  return false;
 }
 
-void LlaSession::stop()
+void LlaSession::stop(bool lease)
 {
+  if (!mSession) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(leases().mutex);
+  if (lease && mHeld && leases().idleWindow.count() > 0 && mSession->isStarted()) {
+    mHeld = false;
+    leases().leases[mSession.get()] = { mSession, mSerialId.getSerial(), RequestClient::get(), std::chrono::steady_clock::now() + leases().idleWindow, false };
+    leases().startReaper();
+    leases().condition.notify_all();
+    return;
+  }
+
+  mHeld = false;
+  leases().leases.erase(mSession.get());
+  if (!mSession->isStarted()) {
+    return;
+  }
   mSession->stop();
+  recordRelease(mSerialId.getSerial());
+}
+
+void LlaSession::setLease(std::chrono::milliseconds idleWindow)
+{
+  std::lock_guard<std::mutex> lock(leases().mutex);
+  leases().idleWindow = idleWindow;
+}
+
+void LlaSession::detach()
+{
+  if (mSession) {
+    std::lock_guard<std::mutex> lock(leases().mutex);
+    leases().leases.erase(mSession.get());
+  }
+  mHeld = false;
+  mDetached = true;
+}
+
+LlaLockStatistics LlaSession::getLockStatistics(int serial)
+{
+  std::lock_guard<std::mutex> lock(lockStatisticsMutex);
+  auto it = lockStatistics.find(serial);
+  return (it != lockStatistics.end()) ? it->second : LlaLockStatistics();
+}
+
+void LlaSession::setLockCallback(std::function<void(int)> callback)
+{
+  std::lock_guard<std::mutex> lock(lockStatisticsMutex);
+  lockCallback = callback;
 }
 
 } // namespace alf
@@ -16,8 +16,12 @@
 /// \author Kostas Alexopoulos (kostas.alexopoulos@cern.ch)
 
 #include <boost/format.hpp>
+#include <array>
 #include <chrono>
+#include <cmath>
 #include <fstream>
+#include <map>
+#include <mutex>
 #include <sstream>
 #include <thread>
 #include <vector>
@@ -28,6 +32,7 @@
 
 #include "Alf/Exception.h"
 #include "Alf/ScBase.h"
+#include "Alf/Swt.h"
 
 #include "Logger.h"
 #include "Util.h"
@@ -42,10 +47,77 @@ namespace o2
 namespace alf
 {
 
+namespace
+{
+/// Circuit breaker state of a link
+struct LinkBreaker {
+  int consecutiveTimeouts = 0;
+  bool down = false;
+  std::chrono::steady_clock::time_point nextProbe;
+};
+
+std::mutex breakersMutex;
+std::map<std::pair<int, int>, LinkBreaker> breakers; // (serial, raw link id) -> breaker
+int breakerThreshold = 0;
+std::chrono::milliseconds breakerProbeInterval(10000);
+std::function<void(const AlfLink&, bool)> linkStateCallback;
+
+/// Histogram of the latencies of a kind of transaction, in logarithmic buckets of a quarter of an octave
+struct LatencyHistogram {
+  static constexpr int kBucketsPerOctave = 4;
+  static constexpr int kNumBuckets = 24 * kBucketsPerOctave; // up to ~16 s
+  static constexpr uint64_t kDecayCount = 20000;             // halve the counts to follow drifting latencies
+
+  std::array<uint64_t, kNumBuckets> buckets = {};
+  uint64_t count = 0;
+
+  void add(std::chrono::microseconds latency)
+  {
+    int bucket = static_cast<int>(kBucketsPerOctave * std::log2(latency.count() + 1.0));
+    buckets[std::min(std::max(bucket, 0), kNumBuckets - 1)]++;
+    if (++count >= kDecayCount) {
+      count = 0;
+      for (auto& bucketCount : buckets) {
+        bucketCount /= 2;
+        count += bucketCount;
+      }
+    }
+  }
+
+  /// \return The upper bound of the bucket holding the given quantile
+  std::chrono::microseconds quantile(double q) const
+  {
+    uint64_t rank = static_cast<uint64_t>(std::ceil(q * count));
+    uint64_t cumulative = 0;
+    int bucket = 0;
+    for (; bucket < kNumBuckets - 1; bucket++) {
+      cumulative += buckets[bucket];
+      if (cumulative >= rank) {
+        break;
+      }
+    }
+    return std::chrono::microseconds(static_cast<int64_t>(std::exp2(double(bucket + 1) / kBucketsPerOctave)));
+  }
+};
+
+constexpr double kTimeoutQuantile = 0.999;
+constexpr uint64_t kMinLatencySamples = 1000; // enough for a meaningful 99.9th percentile
+const std::array<std::chrono::microseconds, ScBase::NumTimeoutKinds> defaultTimeouts = {
+  BUSY_TIMEOUT, std::chrono::milliseconds(Swt::DEFAULT_SWT_TIMEOUT_MS), std::chrono::milliseconds(10)
+};
+
+std::mutex latenciesMutex;
+std::map<std::pair<int, int>, std::array<LatencyHistogram, ScBase::NumTimeoutKinds>> latencies; // (serial, raw link id) -> histograms
+std::array<std::chrono::microseconds, ScBase::NumTimeoutKinds> pinnedTimeouts = {};
+double timeoutFactor = 0;
+std::chrono::microseconds timeoutFloor = std::chrono::milliseconds(1);
+std::chrono::microseconds timeoutCeiling = std::chrono::milliseconds(100);
+} // namespace
+
 ScBase::ScBase(AlfLink link, std::shared_ptr<lla::Session> llaSession)
   : mLink(link), mBar2(link.bar)
 {
-  mLlaSession = std::make_unique<LlaSession>(llaSession);
+  mLlaSession = std::make_unique<LlaSession>(llaSession, link.serialId);
 }
 
 ScBase::ScBase(const roc::Parameters::CardIdType& cardId, int linkId)
@@ -106,6 +178,158 @@ void ScBase::scReset()
   barWrite(sc_regs::SC_RESET.index, 0x0); //void cmd to sync clocks
 }
 
+void ScBase::setOperationCallback(std::function<void()> callback)
+{
+  mOperationCallback = callback;
+}
+
+void ScBase::runOperationCallback()
+{
+  if (mOperationCallback) {
+    mOperationCallback();
+  }
+}
+
+void ScBase::setCircuitBreaker(int threshold, int probeInterval)
+{
+  std::lock_guard<std::mutex> lock(breakersMutex);
+  breakerThreshold = threshold;
+  breakerProbeInterval = std::chrono::milliseconds(probeInterval);
+}
+
+void ScBase::setLinkStateCallback(std::function<void(const AlfLink&, bool)> callback)
+{
+  std::lock_guard<std::mutex> lock(breakersMutex);
+  linkStateCallback = callback;
+}
+
+void ScBase::checkLinkUp()
+{
+  std::lock_guard<std::mutex> lock(breakersMutex);
+  if (breakerThreshold <= 0) {
+    return;
+  }
+
+  auto& breaker = breakers[{ mLink.serialId.getSerial(), mLink.rawLinkId }];
+  if (!breaker.down) {
+    return;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  if (now >= breaker.nextProbe) {
+    // Let this one through as a probe; the others keep failing fast until its outcome
+    breaker.nextProbe = now + breakerProbeInterval;
+    return;
+  }
+
+  BOOST_THROW_EXCEPTION(ScException() << ErrorInfo::Message((boost::format("Link marked down after %d consecutive timeouts serialId=%s link=%d") % breaker.consecutiveTimeouts % mLink.serialId % mLink.linkId).str()));
+}
+
+void ScBase::recordLinkTimeout()
+{
+  std::function<void(const AlfLink&, bool)> callback;
+  {
+    std::lock_guard<std::mutex> lock(breakersMutex);
+    if (breakerThreshold <= 0) {
+      return;
+    }
+
+    auto& breaker = breakers[{ mLink.serialId.getSerial(), mLink.rawLinkId }];
+    breaker.consecutiveTimeouts++;
+    if (breaker.down || breaker.consecutiveTimeouts < breakerThreshold) {
+      return;
+    }
+    breaker.down = true;
+    breaker.nextProbe = std::chrono::steady_clock::now() + breakerProbeInterval;
+    callback = linkStateCallback;
+  }
+
+  Logger::get() << "Link " << mLink.linkId << " of " << mLink.serialId << " marked down" << LogWarningOps_(5013) << endm;
+  if (callback) {
+    callback(mLink, true);
+  }
+}
+
+void ScBase::recordLinkSuccess()
+{
+  std::function<void(const AlfLink&, bool)> callback;
+  {
+    std::lock_guard<std::mutex> lock(breakersMutex);
+    if (breakerThreshold <= 0) {
+      return;
+    }
+
+    auto it = breakers.find({ mLink.serialId.getSerial(), mLink.rawLinkId });
+    if (it == breakers.end()) {
+      return;
+    }
+    bool wasDown = it->second.down;
+    breakers.erase(it);
+    if (!wasDown) {
+      return;
+    }
+    callback = linkStateCallback;
+  }
+
+  Logger::get() << "Link " << mLink.linkId << " of " << mLink.serialId << " back up" << LogInfoOps_(5014) << endm;
+  if (callback) {
+    callback(mLink, false);
+  }
+}
+
+void ScBase::setAdaptiveTimeouts(double factor, int floor, int ceiling)
+{
+  std::lock_guard<std::mutex> lock(latenciesMutex);
+  timeoutFactor = factor;
+  timeoutFloor = std::chrono::milliseconds(floor);
+  timeoutCeiling = std::chrono::milliseconds(std::max(floor, ceiling));
+}
+
+void ScBase::pinTimeout(TimeoutKind kind, int timeout)
+{
+  std::lock_guard<std::mutex> lock(latenciesMutex);
+  pinnedTimeouts[kind] = std::chrono::milliseconds(timeout);
+}
+
+std::chrono::microseconds ScBase::getTimeout(const AlfLink& link, TimeoutKind kind)
+{
+  std::lock_guard<std::mutex> lock(latenciesMutex);
+  if (pinnedTimeouts[kind].count() > 0) {
+    return pinnedTimeouts[kind];
+  }
+  if (timeoutFactor <= 0) {
+    return defaultTimeouts[kind];
+  }
+
+  auto it = latencies.find({ link.serialId.getSerial(), link.rawLinkId });
+  if (it == latencies.end() || it->second[kind].count < kMinLatencySamples) {
+    return defaultTimeouts[kind];
+  }
+  auto timeout = std::chrono::microseconds(static_cast<int64_t>(it->second[kind].quantile(kTimeoutQuantile).count() * timeoutFactor));
+  return std::min(std::max(timeout, timeoutFloor), timeoutCeiling);
+}
+
+std::chrono::microseconds ScBase::getLatencyQuantile(const AlfLink& link, TimeoutKind kind, double quantile)
+{
+  std::lock_guard<std::mutex> lock(latenciesMutex);
+  auto it = latencies.find({ link.serialId.getSerial(), link.rawLinkId });
+  if (it == latencies.end() || it->second[kind].count < kMinLatencySamples) {
+    return std::chrono::microseconds(0);
+  }
+  return it->second[kind].quantile(quantile);
+}
+
+std::chrono::microseconds ScBase::getTimeout(TimeoutKind kind)
+{
+  return getTimeout(mLink, kind);
+}
+
+void ScBase::recordLatency(TimeoutKind kind, std::chrono::steady_clock::duration latency)
+{
+  std::lock_guard<std::mutex> lock(latenciesMutex);
+  latencies[{ mLink.serialId.getSerial(), mLink.rawLinkId }][kind].add(std::chrono::duration_cast<std::chrono::microseconds>(latency));
+}
+
 void ScBase::barWrite(uint32_t index, uint32_t data)
 {
   uint32_t linkIndex = (0x00f00000 + (mLink.rawLinkId << 8)) / 4 + index;
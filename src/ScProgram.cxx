@@ -0,0 +1,365 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file ScProgram.cxx
+/// \brief Implementation of the SC program compiler and interpreter for the ALF server
+
+#include <boost/algorithm/string.hpp>
+#include <boost/format.hpp>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <sstream>
+#include <thread>
+
+#include "Alf/Exception.h"
+#include "Alf/Ic.h"
+#include "Alf/Sca.h"
+#include "Alf/Swt.h"
+#include "DimServices/DimServices.h"
+#include "ScProgram.h"
+#include "Util.h"
+
+namespace o2
+{
+namespace alf
+{
+
+namespace
+{
+/// Operation description: opcode, number of value operands, whether it writes a destination register first, and
+/// whether it takes a label last
+struct OpInfo {
+  int opCode;
+  size_t minOperands;
+  size_t maxOperands;
+  bool hasDestination;
+  bool hasLabel;
+};
+} // namespace
+
+ScProgram::Operand ScProgram::parseOperand(const std::string& token, int line)
+{
+  std::string operand = boost::trim_copy(token);
+  try {
+    if (operand.size() > 1 && operand[0] == 'r') {
+      int index = std::stoi(operand.substr(1));
+      if (index < 0 || index >= kNumRegisters) {
+        BOOST_THROW_EXCEPTION(std::out_of_range("register out of range"));
+      }
+      return { true, (uint32_t)index };
+    }
+    // hex with a 0x prefix, decimal otherwise
+    uint64_t value = std::stoul(operand, nullptr, boost::starts_with(operand, "0x") ? 16 : 10);
+    if (value > std::numeric_limits<uint32_t>::max()) {
+      BOOST_THROW_EXCEPTION(std::out_of_range("value does not fit in 32-bit unsigned int"));
+    }
+    return { false, (uint32_t)value };
+  } catch (const std::exception& e) {
+    BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message((boost::format("SC_PROGRAM line %d: invalid operand '%s'") % line % operand).str()));
+  }
+}
+
+ScProgram::ScProgram(const std::vector<std::string>& lines)
+{
+  static const std::map<std::string, OpInfo> opInfos = {
+    { "set", { Set, 1, 1, true, false } },
+    { "add", { Add, 2, 2, true, false } },
+    { "sub", { Sub, 2, 2, true, false } },
+    { "and", { And, 2, 2, true, false } },
+    { "or", { Or, 2, 2, true, false } },
+    { "xor", { Xor, 2, 2, true, false } },
+    { "shl", { Shl, 2, 2, true, false } },
+    { "shr", { Shr, 2, 2, true, false } },
+    { "reg_read", { RegRead, 1, 1, true, false } },
+    { "reg_write", { RegWrite, 2, 2, false, false } },
+    { "sca", { ScaCommand, 2, 2, true, false } },
+    { "sc_reset", { ScReset, 0, 0, false, false } },
+    { "svl_reset", { SvlReset, 0, 0, false, false } },
+    { "svl_connect", { SvlConnect, 0, 0, false, false } },
+    { "swt_write", { SwtWrite, 1, 3, false, false } },
+    { "swt_read", { SwtRead, 0, 0, true, false } },
+    { "ic_read", { IcRead, 1, 1, true, false } },
+    { "ic_write", { IcWrite, 2, 2, false, false } },
+    { "wait", { Wait, 1, 1, false, false } },
+    { "beq", { BranchEqual, 3, 3, false, true } },
+    { "bne", { BranchNotEqual, 3, 3, false, true } },
+    { "jump", { Jump, 0, 0, false, true } },
+    { "loop", { Loop, 0, 0, true, true } },
+    { "out", { Out, 1, 1, false, false } },
+    { "halt", { Halt, 0, 0, false, false } },
+  };
+
+  auto error = [](int line, const std::string& message) {
+    BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message((boost::format("SC_PROGRAM line %d: %s") % line % message).str()));
+  };
+
+  // First pass: tokenize, collect labels
+  std::map<std::string, size_t> labels;
+  std::vector<std::pair<int, std::vector<std::string>>> statements;
+  int line = 0;
+  for (const auto& stringLine : lines) {
+    line++;
+    if (stringLine.find('#') != std::string::npos || boost::trim_copy(stringLine).empty()) {
+      continue;
+    }
+    std::vector<std::string> tokens = Util::split(stringLine, pairSeparator());
+    for (auto& token : tokens) {
+      boost::trim(token);
+    }
+    std::string op = tokens.back();
+
+    if (op == "lock") {
+      if (!statements.empty() || tokens.size() != 1) {
+        error(line, "lock needs to lead the program and takes no arguments");
+      }
+      mLock = true;
+    } else if (op == "label") {
+      if (tokens.size() != 2 || labels.count(tokens[0])) {
+        error(line, "label needs a single unique name");
+      }
+      labels[tokens[0]] = statements.size();
+    } else {
+      statements.push_back({ line, tokens });
+    }
+  }
+
+  // Second pass: compile to instructions and resolve labels
+  for (const auto& statement : statements) {
+    line = statement.first;
+    std::vector<std::string> tokens = statement.second;
+    std::string op = tokens.back();
+    tokens.pop_back();
+
+    auto it = opInfos.find(op);
+    if (it == opInfos.end()) {
+      error(line, "unknown operation '" + op + "'");
+    }
+    const OpInfo& info = it->second;
+
+    Instruction instruction;
+    instruction.opCode = (OpCode)info.opCode;
+    instruction.target = 0;
+    instruction.line = line;
+
+    if (info.hasLabel) {
+      if (tokens.empty() || !labels.count(tokens.back())) {
+        error(line, "unknown label for '" + op + "'");
+      }
+      instruction.target = labels[tokens.back()];
+      tokens.pop_back();
+    }
+
+    size_t destinations = info.hasDestination ? 1 : 0;
+    if (tokens.size() < info.minOperands + destinations || tokens.size() > info.maxOperands + destinations) {
+      error(line, "wrong number of arguments for '" + op + "'");
+    }
+
+    for (const auto& token : tokens) {
+      instruction.operands.push_back(parseOperand(token, line));
+    }
+    if (info.hasDestination && !instruction.operands[0].isRegister) {
+      error(line, "destination of '" + op + "' needs to be a register");
+    }
+
+    mUsesSca |= (instruction.opCode >= ScaCommand && instruction.opCode <= SvlConnect);
+    mUsesSwt |= (instruction.opCode == SwtWrite || instruction.opCode == SwtRead);
+    mUsesIc |= (instruction.opCode == IcRead || instruction.opCode == IcWrite);
+    mInstructions.push_back(instruction);
+  }
+}
+
+std::string ScProgram::run(AlfLink link, std::shared_ptr<lla::Session> llaSession, SwtWord::Size swtWordSize) const
+{
+  std::stringstream resultBuffer;
+  std::array<uint32_t, kNumRegisters> registers = {};
+
+  // SC handles are only created if used, as the IC constructor accesses the link
+  std::unique_ptr<Sca> sca;
+  std::unique_ptr<Swt> swt;
+  std::unique_ptr<Ic> ic;
+
+  LlaSession session(llaSession, link.serialId);
+  if (mLock) {
+    try {
+      session.start();
+    } catch (const lla::LlaException& e) {
+      BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("Could not start session for SC_PROGRAM"));
+    }
+  }
+
+  size_t pc = 0;
+  uint64_t steps = 0;
+  int line = 0;
+  try {
+    while (pc < mInstructions.size()) {
+      if (++steps > kMaxSteps) {
+        BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message("Maximum number of steps exceeded"));
+      }
+      RequestDeadline::check();
+
+      const Instruction& instruction = mInstructions[pc++];
+      const auto& operands = instruction.operands;
+      line = instruction.line;
+      auto value = [&](size_t i) {
+        return operands[i].isRegister ? registers[operands[i].value] : operands[i].value;
+      };
+      auto destination = [&]() -> uint32_t& {
+        return registers[operands[0].value];
+      };
+
+      switch (instruction.opCode) {
+        case Set:
+          destination() = value(1);
+          break;
+        case Add:
+          destination() = value(1) + value(2);
+          break;
+        case Sub:
+          destination() = value(1) - value(2);
+          break;
+        case And:
+          destination() = value(1) & value(2);
+          break;
+        case Or:
+          destination() = value(1) | value(2);
+          break;
+        case Xor:
+          destination() = value(1) ^ value(2);
+          break;
+        case Shl:
+          destination() = value(2) < 32 ? value(1) << value(2) : 0;
+          break;
+        case Shr:
+          destination() = value(2) < 32 ? value(1) >> value(2) : 0;
+          break;
+        case RegRead:
+        case RegWrite: {
+          uint32_t address = (instruction.opCode == RegRead) ? value(1) : value(0);
+          if (link.cardType == roc::CardType::Cru && (address < 0x00c00000 || address > 0x00cfffff)) {
+            BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message((boost::format("Illegal address 0x%08x, allowed: [0x00c0_0000-0x00cf_ffff]") % address).str()));
+          }
+          if (instruction.opCode == RegRead) {
+            destination() = link.bar->readRegister(address / 4);
+          } else {
+            link.bar->writeRegister(address / 4, value(1));
+          }
+          break;
+        }
+        case ScaCommand:
+          if (!sca) {
+            sca = std::make_unique<Sca>(link, llaSession);
+            sca->checkLinkUp();
+          }
+          destination() = sca->executeCommand(value(1), value(2)).data;
+          break;
+        case ScReset:
+          if (!sca) {
+            sca = std::make_unique<Sca>(link, llaSession);
+            sca->checkLinkUp();
+          }
+          sca->scReset();
+          break;
+        case SvlReset:
+        case SvlConnect:
+          if (!sca) {
+            sca = std::make_unique<Sca>(link, llaSession);
+            sca->checkLinkUp();
+          }
+          if (instruction.opCode == SvlReset) {
+            sca->svlReset();
+          } else {
+            sca->svlConnect();
+          }
+          break;
+        case SwtWrite:
+          if (!swt) {
+            swt = std::make_unique<Swt>(link, llaSession, swtWordSize);
+            swt->checkLinkUp();
+          }
+          swt->write(SwtWord(value(0),
+                             operands.size() > 1 ? value(1) : 0x0,
+                             operands.size() > 2 ? value(2) : 0x0,
+                             operands.size() > 2 ? SwtWord::Size::High : (operands.size() > 1 ? SwtWord::Size::Medium : SwtWord::Size::Low)));
+          break;
+        case SwtRead:
+          if (!swt) {
+            swt = std::make_unique<Swt>(link, llaSession, swtWordSize);
+            swt->checkLinkUp();
+          }
+          destination() = swt->read(swtWordSize).back().getLow();
+          break;
+        case IcRead:
+        case IcWrite:
+          if (!ic) {
+            ic = std::make_unique<Ic>(link, llaSession);
+            ic->checkLinkUp();
+          }
+          if (instruction.opCode == IcRead) {
+            destination() = ic->read(value(1));
+          } else {
+            ic->write(value(0), value(1));
+          }
+          break;
+        case Wait: {
+          if (value(0) > kMaxWait) {
+            BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message((boost::format("Wait of %d ms exceeds the maximum of %d ms") % value(0) % kMaxWait).str()));
+          }
+          // Sleep in slices, so that an expired request doesn't keep holding the lanes
+          constexpr auto slice = std::chrono::milliseconds(10);
+          auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(value(0));
+          for (auto now = std::chrono::steady_clock::now(); now < end; now = std::chrono::steady_clock::now()) {
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(slice, end - now));
+            RequestDeadline::check();
+          }
+          break;
+        }
+        case BranchEqual:
+        case BranchNotEqual: {
+          bool equal = (value(0) & value(2)) == (value(1) & value(2));
+          if (equal == (instruction.opCode == BranchEqual)) {
+            pc = instruction.target;
+          }
+          break;
+        }
+        case Jump:
+          pc = instruction.target;
+          break;
+        case Loop:
+          if (--destination() != 0) {
+            pc = instruction.target;
+          }
+          break;
+        case Out:
+          resultBuffer << Util::formatValue(value(0)) << "\n";
+          break;
+        case Halt:
+          pc = mInstructions.size();
+          break;
+      }
+    }
+  } catch (const std::exception& e) {
+    if (mLock) {
+      session.stop();
+    }
+    resultBuffer << (boost::format("SC_PROGRAM line %d serialId=%s link=%d error='%s'") % line % link.serialId % link.linkId % e.what()).str();
+    BOOST_THROW_EXCEPTION(AlfException() << ErrorInfo::Message(resultBuffer.str()));
+  }
+
+  if (mLock) {
+    session.stop(true);
+  }
+
+  return resultBuffer.str();
+}
+
+} // namespace alf
+} // namespace o2
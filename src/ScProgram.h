@@ -0,0 +1,116 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file ScProgram.h
+/// \brief Definition of the SC program compiler and interpreter for the ALF server
+
+#ifndef O2_ALF_SRC_SCPROGRAM_H_
+#define O2_ALF_SRC_SCPROGRAM_H_
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "Alf/Common.h"
+#include "Alf/SwtWord.h"
+#include "Lla/Lla.h"
+
+namespace lla = o2::lla;
+
+namespace o2
+{
+namespace alf
+{
+
+/// Class compiling SC program text to bytecode once, and running it against the SCA, SWT, IC and BAR primitives
+/// of a link. Programs hold read results in registers (r0-r15), and support arithmetic, bounded loops and branches on
+/// masked compares.
+class ScProgram
+{
+ public:
+  /// Compiles an SC program
+  /// \param lines The program lines, each made up of comma-separated operands followed by the operation
+  /// \throws o2::alf::AlfException on syntax error
+  ScProgram(const std::vector<std::string>& lines);
+
+  /// Runs the compiled program on a link
+  /// \param link The AlfLink to run the program on
+  /// \param llaSession The card's LLA session, used if the program is locked
+  /// \param swtWordSize The size of the SWT words read
+  /// \return A string of newline separated values from the out operations
+  /// \throws o2::alf::AlfException on error, with the output produced so far
+  std::string run(AlfLink link, std::shared_ptr<lla::Session> llaSession, SwtWord::Size swtWordSize) const;
+
+  /// \return Whether the program has instructions using the SCA, SWT or IC core of the link
+  bool usesSca() const { return mUsesSca; }
+  bool usesSwt() const { return mUsesSwt; }
+  bool usesIc() const { return mUsesIc; }
+
+  /// Number of registers available to programs
+  static constexpr int kNumRegisters = 16;
+  /// Maximum number of instructions executed, bounding loops and jumps
+  static constexpr uint64_t kMaxSteps = 1000000;
+  /// Maximum duration of a wait instruction in ms
+  static constexpr uint32_t kMaxWait = 60000;
+
+ private:
+  enum OpCode { Set,
+                Add,
+                Sub,
+                And,
+                Or,
+                Xor,
+                Shl,
+                Shr,
+                RegRead,
+                RegWrite,
+                ScaCommand,
+                ScReset,
+                SvlReset,
+                SvlConnect,
+                SwtWrite,
+                SwtRead,
+                IcRead,
+                IcWrite,
+                Wait,
+                BranchEqual,
+                BranchNotEqual,
+                Jump,
+                Loop,
+                Out,
+                Halt };
+
+  /// A register (r0-r15) or an immediate value
+  struct Operand {
+    bool isRegister;
+    uint32_t value;
+  };
+
+  struct Instruction {
+    OpCode opCode;
+    std::vector<Operand> operands;
+    size_t target; // jump target, for branches
+    int line;      // source line, for error messages
+  };
+
+  static Operand parseOperand(const std::string& token, int line);
+
+  std::vector<Instruction> mInstructions;
+  bool mLock = false;
+  bool mUsesSca = false;
+  bool mUsesSwt = false;
+  bool mUsesIc = false;
+};
+
+} // namespace alf
+} // namespace o2
+
+#endif // O2_ALF_SRC_SCPROGRAM_H_
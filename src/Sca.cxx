@@ -102,6 +102,41 @@ Sca::CommandData Sca::executeCommand(uint32_t command, uint32_t data, bool lock,
   return result;
 }
 
+Sca::CommandData Sca::readModifyWrite(RmwData rmwData, int lockTimeout)
+{
+  checkChannelSet();
+
+  // Only release the session if it was not already held (e.g. by a locked sequence)
+  struct SessionGuard {
+    std::shared_ptr<LlaSession> session;
+    bool started;
+    ~SessionGuard()
+    {
+      if (started) {
+        session->stop();
+      }
+    }
+  } guard{ mLlaSession, mLlaSession->start(lockTimeout) };
+
+  auto current = executeCommand(rmwData.readCommand, 0x0);
+  uint32_t data = (current.data & ~rmwData.mask) | (rmwData.data & rmwData.mask);
+  return executeCommand(rmwData.writeCommand, data);
+}
+
+Sca::PollData Sca::poll(PollData pollData)
+{
+  auto isDone = [&]() {
+    pollData.reply = executeCommand(pollData.commandData);
+    return (pollData.reply.data & pollData.mask) == (pollData.expected & pollData.mask);
+  };
+
+  if (!Util::pollUntil(isDone, pollData.interval, pollData.timeout, pollData.elapsed, [this]() { runOperationCallback(); })) {
+    BOOST_THROW_EXCEPTION(ScaException() << ErrorInfo::Message(
+                            (boost::format("Poll timeout after %d ms, last data=0x%08x") % pollData.elapsed % pollData.reply.data).str()));
+  }
+  return pollData;
+}
+
 void Sca::write(uint32_t command, uint32_t data)
 {
   waitOnBusyClear();
@@ -128,16 +163,25 @@ Sca::CommandData Sca::read()
   /* printf("Sca::read   DATA=0x%x   CH=0x%x   TR=0x%x   CMD=0x%x\n", data,
    command >> 24, (command >> 16) & 0xff, command & 0xff);*/
 
-  auto endTime = std::chrono::steady_clock::now() + CHANNEL_BUSY_TIMEOUT;
-  while (std::chrono::steady_clock::now() < endTime) {
+  auto isChannelReady = [&]() {
     if (!isChannelBusy(command)) {
-      checkError(command);
-      return { command, data };
+      return true;
     }
     data = barRead(sc_regs::SCA_RD_DATA.index);
     command = barRead(sc_regs::SCA_RD_CMD.index);
+    return false;
+  };
+  auto start = std::chrono::steady_clock::now();
+  bool ready = Util::waitUntil(isChannelReady, start + getTimeout(ScaTimeout));
+  recordLatency(ScaTimeout, std::chrono::steady_clock::now() - start);
+  if (ready) {
+    recordLinkSuccess();
+    checkError(command);
+    return { command, data };
   }
 
+  recordLinkTimeout();
+
   std::stringstream ss;
   ss << "command: " << command << " data: " << data;
   BOOST_THROW_EXCEPTION(ScaException() << ErrorInfo::Message(
@@ -208,21 +252,24 @@ void Sca::execute()
 
 void Sca::waitOnBusyClear()
 {
-  int count = 10;
-  auto sleepSlice = BUSY_TIMEOUT / count;
-  while (count--) {
-    if ((((barRead(sc_regs::SCA_RD_CTRL.index)) >> 31) & 0x1) == 0) {
-      return;
-    }
-    std::this_thread::sleep_for(sleepSlice);
+  auto isBusyClear = [&]() { return (((barRead(sc_regs::SCA_RD_CTRL.index)) >> 31) & 0x1) == 0; };
+  auto start = std::chrono::steady_clock::now();
+  bool clear = Util::waitUntil(isBusyClear, start + getTimeout(ScaTimeout));
+  recordLatency(ScaTimeout, std::chrono::steady_clock::now() - start);
+  if (clear) {
+    return;
   }
 
+  recordLinkTimeout();
+
   BOOST_THROW_EXCEPTION(ScaException()
                         << ErrorInfo::Message("Exceeded timeout on busy wait"));
 }
 
 std::vector<std::pair<Sca::Operation, Sca::Data>> Sca::executeSequence(const std::vector<std::pair<Operation, Data>>& operations, bool lock, int lockTimeout)
 {
+  checkLinkUp();
+
   if (lock) {
     mLlaSession->start(lockTimeout);
   }
@@ -235,6 +282,7 @@ std::vector<std::pair<Sca::Operation, Sca::Data>> Sca::executeSequence(const std
 
   std::vector<std::pair<Sca::Operation, Sca::Data>> ret;
   for (const auto& it : operations) {
+    runOperationCallback();
     Operation operation = it.first;
     Data data = it.second;
     try {
@@ -242,6 +290,12 @@ std::vector<std::pair<Sca::Operation, Sca::Data>> Sca::executeSequence(const std
         auto commandData = boost::get<CommandData>(data);
         auto result = executeCommand(commandData);
         ret.push_back({ operation, result });
+      } else if (operation == Operation::ReadModifyWrite) {
+        auto result = readModifyWrite(boost::get<RmwData>(data), lockTimeout);
+        ret.push_back({ operation, result });
+      } else if (operation == Operation::Poll) {
+        auto result = poll(boost::get<PollData>(data));
+        ret.push_back({ operation, result });
       } else if (operation == Operation::Wait) {
         int waitTime;
         try {
@@ -270,6 +324,12 @@ std::vector<std::pair<Sca::Operation, Sca::Data>> Sca::executeSequence(const std
       std::string meaningfulMessage;
       if (operation == Operation::Command) {
         meaningfulMessage = (boost::format("SCA_SEQUENCE cmd=0x%08x data=0x%08x serialId=%s link=%d error='%s'") % boost::get<CommandData>(data).command % boost::get<CommandData>(data).data % mLink.serialId % mLink.linkId % e.what()).str();
+      } else if (operation == Operation::ReadModifyWrite) {
+        auto rmwData = boost::get<RmwData>(data);
+        meaningfulMessage = (boost::format("SCA_SEQUENCE RMW read_cmd=0x%08x write_cmd=0x%08x mask=0x%08x data=0x%08x serialId=%s link=%d error='%s'") % rmwData.readCommand % rmwData.writeCommand % rmwData.mask % rmwData.data % mLink.serialId % mLink.linkId % e.what()).str();
+      } else if (operation == Operation::Poll) {
+        auto pollData = boost::get<PollData>(data);
+        meaningfulMessage = (boost::format("SCA_SEQUENCE POLL cmd=0x%08x data=0x%08x mask=0x%08x expected=0x%08x serialId=%s link=%d error='%s'") % pollData.commandData.command % pollData.commandData.data % pollData.mask % pollData.expected % mLink.serialId % mLink.linkId % e.what()).str();
       } else if (operation == Operation::Wait) {
         meaningfulMessage = (boost::format("SCA_SEQUENCE WAIT waitTime=%d serialId=%s link=%d error='%s'") % boost::get<WaitTime>(data) % mLink.serialId % mLink.linkId % e.what()).str();
       } else if (operation == Operation::SVLReset) {
@@ -289,21 +349,27 @@ std::vector<std::pair<Sca::Operation, Sca::Data>> Sca::executeSequence(const std
   }
 
   if (lock) {
-    mLlaSession->stop();
+    mLlaSession->stop(true);
   }
 
   return ret;
 }
 
 std::string Sca::writeSequence(const std::vector<std::pair<Operation, Data>>& operations, bool lock, int lockTimeout)
+{
+  return formatSequenceOutput(executeSequence(operations, lock, lockTimeout));
+}
+
+std::string Sca::formatSequenceOutput(const std::vector<std::pair<Operation, Data>>& out)
 {
   std::stringstream resultBuffer;
-  auto out = executeSequence(operations, lock, lockTimeout);
   for (const auto& it : out) {
     Operation operation = it.first;
     Data data = it.second;
-    if (operation == Operation::Command) {
+    if (operation == Operation::Command || operation == Operation::ReadModifyWrite) {
       resultBuffer << data << "\n"; // "[cmd],[data]\n"
+    } else if (operation == Operation::Poll) {
+      resultBuffer << data << "\n"; // "[cmd],[data],[elapsed]\n"
     } else if (operation == Operation::Wait) {
       resultBuffer << std::dec << data << "\n"; // "[time]\n"
     } else if (operation == Operation::SVLReset || operation == Operation::SCReset) {
@@ -337,6 +403,10 @@ std::string Sca::ScaOperationToString(Sca::Operation op)
     return "svl_connect";
   } else if (op == Sca::Operation::Lock) {
     return "lock";
+  } else if (op == Sca::Operation::ReadModifyWrite) {
+    return "rmw";
+  } else if (op == Sca::Operation::Poll) {
+    return "poll";
   } else if (op == Sca::Operation::Error) {
     return "error";
   }
@@ -358,6 +428,10 @@ Sca::Operation Sca::StringToScaOperation(std::string op)
     return Sca::Operation::SVLConnect;
   } else if (op == "lock") {
     return Sca::Operation::Lock;
+  } else if (op == "rmw") {
+    return Sca::Operation::ReadModifyWrite;
+  } else if (op == "poll") {
+    return Sca::Operation::Poll;
   } else if (op == "error") {
     return Sca::Operation::Error;
   }
@@ -371,5 +445,18 @@ std::ostream& operator<<(std::ostream& output, const Sca::CommandData& commandDa
   return output;
 }
 
+std::ostream& operator<<(std::ostream& output, const Sca::RmwData& rmwData)
+{
+  output << Util::formatValue(rmwData.readCommand) << "," << Util::formatValue(rmwData.writeCommand) << ","
+         << Util::formatValue(rmwData.mask) << "," << Util::formatValue(rmwData.data);
+  return output;
+}
+
+std::ostream& operator<<(std::ostream& output, const Sca::PollData& pollData)
+{
+  output << pollData.reply << "," << std::dec << pollData.elapsed;
+  return output;
+}
+
 } // namespace alf
 } // namespace o2
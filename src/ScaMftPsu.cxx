@@ -128,14 +128,17 @@ ScaMftPsu::CommandData ScaMftPsu::read()
   // printf("ScaMftPsu::read   DATA=0x%x   CH=0x%x   TR=0x%x   CMD=0x%x\n", data,
   // command >> 24, (command >> 16) & 0xff, command & 0xff);
 
-  auto endTime = std::chrono::steady_clock::now() + CHANNEL_BUSY_TIMEOUT;
-  while (std::chrono::steady_clock::now() < endTime) {
+  auto isChannelReady = [&]() {
     if (!isChannelBusy(command)) {
-      checkError(command);
-      return { command, data };
+      return true;
     }
     data = barRead((sc_regs::SCA_MFT_PSU_DATA.address + 0x100 * mLink.rawLinkId) / 4);
     command = barRead((sc_regs::SCA_MFT_PSU_CMD.address + 0x100 * mLink.rawLinkId) / 4);
+    return false;
+  };
+  if (Util::waitUntil(isChannelReady, std::chrono::steady_clock::now() + CHANNEL_BUSY_TIMEOUT)) {
+    checkError(command);
+    return { command, data };
   }
 
   std::stringstream ss;
@@ -218,11 +221,9 @@ void ScaMftPsu::execute()
 
 void ScaMftPsu::waitOnBusyClear()
 {
-  auto endTime = std::chrono::steady_clock::now() + BUSY_TIMEOUT;
-  while (std::chrono::steady_clock::now() < endTime) {
-    if ((((barRead((sc_regs::SCA_MFT_PSU_CTRL.address + 0x100 * mLink.rawLinkId) / 4)) >> 31) & 0x1) == 0) {
-      return;
-    }
+  auto isBusyClear = [&]() { return (((barRead((sc_regs::SCA_MFT_PSU_CTRL.address + 0x100 * mLink.rawLinkId) / 4)) >> 31) & 0x1) == 0; };
+  if (Util::waitUntil(isBusyClear, std::chrono::steady_clock::now() + BUSY_TIMEOUT)) {
+    return;
   }
 
   BOOST_THROW_EXCEPTION(ScaMftPsuException()
@@ -301,7 +302,7 @@ std::vector<std::pair<ScaMftPsu::Operation, ScaMftPsu::Data>> ScaMftPsu::execute
   }
 
   if (lock) {
-    mLlaSession->stop();
+    mLlaSession->stop(true);
   }
 
   return ret;
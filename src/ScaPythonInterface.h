@@ -246,6 +246,18 @@ struct ScaDataToPython {
       return bp::incref(bp::object(ret).ptr());
     }
 
+    auto operator()(Sca::RmwData rmwData) const
+    {
+      bp::tuple ret = bp::make_tuple(rmwData.readCommand, rmwData.writeCommand, rmwData.mask, rmwData.data);
+      return bp::incref(bp::object(ret).ptr());
+    }
+
+    auto operator()(Sca::PollData pollData) const
+    {
+      bp::tuple ret = bp::make_tuple(pollData.reply.command, pollData.reply.data, pollData.elapsed);
+      return bp::incref(bp::object(ret).ptr());
+    }
+
     auto operator()(int data) const
     {
       return bp::incref(bp::object(data).ptr());
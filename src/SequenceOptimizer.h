@@ -0,0 +1,167 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file SequenceOptimizer.h
+/// \brief Definition of the optimizer pass run on parsed sequences before their execution
+
+#ifndef O2_ALF_SRC_SEQUENCEOPTIMIZER_H_
+#define O2_ALF_SRC_SEQUENCEOPTIMIZER_H_
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace o2
+{
+namespace alf
+{
+
+/// Server-wide statistics of the sequence optimizer
+struct SequenceOptimizerStatistics {
+  inline static std::atomic<uint64_t> sequences{ 0 };
+  inline static std::atomic<uint64_t> opsRemoved{ 0 };
+  inline static std::atomic<uint64_t> savedUs{ 0 };
+};
+
+/// Folds the ops of a sequence into the op before them where it doesn't change the outcome, e.g. merging adjacent
+/// waits or dropping repeated resets. The output of the optimized sequence is restored line for line, by echoing
+/// the folded ops back in place of the op they were folded into.
+template <typename Operation, typename Data>
+class SequenceOptimizer
+{
+ public:
+  typedef std::pair<Operation, Data> Op;
+
+  /// Folds an op into the previous one
+  /// \param previous The previous op of the optimized sequence, updated with the folded op, e.g. for merged waits
+  /// \param op The op to fold
+  /// \return true if the op was folded
+  typedef std::function<bool(Op& previous, const Op& op)> Fold;
+
+  /// \return The estimated time taken by an op
+  typedef std::function<std::chrono::microseconds(const Op& op)> Cost;
+
+  /// Optimizes a sequence
+  /// \param sequence The sequence to optimize
+  /// \param fold Folds an op into the previous one, if possible
+  /// \param cost Estimates the time saved by folding an op away
+  SequenceOptimizer(const std::vector<Op>& sequence, Fold fold, Cost cost)
+  {
+    for (const auto& op : sequence) {
+      if (!mSequence.empty()) {
+        Op previous = mSequence.back();
+        if (fold(previous, op)) {
+          auto& folded = mFolded[mSequence.size() - 1];
+          if (folded.empty()) {
+            folded.push_back(mSequence.back());
+          }
+          folded.push_back(op);
+          mSequence.back() = previous;
+          mSaved += cost(op);
+          continue;
+        }
+      }
+      mSequence.push_back(op);
+    }
+
+    SequenceOptimizerStatistics::sequences++;
+    SequenceOptimizerStatistics::opsRemoved += removed(sequence.size());
+    SequenceOptimizerStatistics::savedUs += mSaved.count();
+  }
+
+  /// \return The optimized sequence
+  const std::vector<Op>& sequence() const
+  {
+    return mSequence;
+  }
+
+  /// \return The estimated time saved
+  std::chrono::microseconds saved() const
+  {
+    return mSaved;
+  }
+
+  /// Restores the output of the original sequence from the output of the optimized one. Each op with folded ops
+  /// must produce one output entry, tagged with its operation.
+  /// \param output Output of the optimized sequence, as (operation, data) entries
+  void restore(std::vector<Op>& output) const
+  {
+    if (mFolded.empty()) {
+      return;
+    }
+
+    // (operation, n) -> index of the optimized op producing the nth output entry of the operation
+    std::map<std::pair<Operation, int>, size_t> foldedOutputs;
+    std::map<Operation, int> counts;
+    for (size_t i = 0; i < mSequence.size(); i++) {
+      int n = counts[mSequence[i].first]++;
+      if (mFolded.count(i)) {
+        foldedOutputs[{ mSequence[i].first, n }] = i;
+      }
+    }
+
+    std::vector<Op> restored;
+    counts.clear();
+    for (const auto& entry : output) {
+      auto it = foldedOutputs.find({ entry.first, counts[entry.first]++ });
+      if (it == foldedOutputs.end()) {
+        restored.push_back(entry);
+      } else {
+        const auto& folded = mFolded.at(it->second);
+        restored.insert(restored.end(), folded.begin(), folded.end());
+      }
+    }
+    output = restored;
+  }
+
+  /// Restores the output of the original sequence from the output of the optimized one, for sequences producing one
+  /// line per op, where the folded ops produce the same line as the op they were folded into
+  /// \param output Output of the optimized sequence, as newline-separated lines
+  std::string restoreLines(const std::string& output) const
+  {
+    if (mFolded.empty()) {
+      return output;
+    }
+
+    std::stringstream input(output);
+    std::stringstream restored;
+    std::string line;
+    for (size_t i = 0; std::getline(input, line); i++) {
+      auto it = mFolded.find(i);
+      size_t repeat = (it == mFolded.end()) ? 1 : it->second.size();
+      for (size_t j = 0; j < repeat; j++) {
+        restored << line << "\n";
+      }
+    }
+    return restored.str();
+  }
+
+ private:
+  int removed(size_t originalSize) const
+  {
+    return originalSize - mSequence.size();
+  }
+
+  std::vector<Op> mSequence;
+  /// index in the optimized sequence -> original ops folded into it, itself included
+  std::map<size_t, std::vector<Op>> mFolded;
+  std::chrono::microseconds mSaved{ 0 };
+};
+
+} // namespace alf
+} // namespace o2
+
+#endif // O2_ALF_SRC_SEQUENCEOPTIMIZER_H_
@@ -36,6 +36,7 @@
 #include "ReadoutCard/ChannelFactory.h"
 #include "ReadoutCard/Cru.h"
 #include "Alf/Swt.h"
+#include "Util.h"
 
 namespace o2
 {
@@ -75,14 +76,19 @@ std::vector<SwtWord> Swt::read(SwtWord::Size wordSize, TimeOut msTimeOut)
   std::vector<SwtWord> words;
   uint32_t numWords = 0x0;
 
-  auto timeOut = std::chrono::steady_clock::now() + std::chrono::milliseconds(msTimeOut);
-  while ((std::chrono::steady_clock::now() < timeOut) && numWords < 1) {
+  auto hasWords = [&]() {
     numWords = (barRead(sc_regs::SWT_MON.index) >> 16);
-  }
+    return numWords >= 1;
+  };
+  auto start = std::chrono::steady_clock::now();
+  Util::waitUntil(hasWords, start + std::chrono::milliseconds(msTimeOut));
+  recordLatency(SwtTimeout, std::chrono::steady_clock::now() - start);
 
+  // An empty READ FIFO is no SC transaction timeout, the link may just have nothing to reply
   if (numWords < 1) { // #WORDS in READ FIFO
     BOOST_THROW_EXCEPTION(SwtException() << ErrorInfo::Message("Not enough words in SWT READ FIFO"));
   }
+  recordLinkSuccess();
 
   for (int i = 0; i < (int)numWords; i++) {
     SwtWord tempWord;
@@ -114,15 +120,19 @@ std::vector<SwtWord> Swt::readMultiple(SwtWord::Size wordSize, unsigned int word
  while (readWords < wordsToRead) {
    uint32_t numWords = 0x0;
 
-   auto timeOut = std::chrono::steady_clock::now() + std::chrono::milliseconds(msTimeOut);
-   bool isTimeout = false;
-   while (!isTimeout && (numWords < 1)) {
+   auto hasWords = [&]() {
      numWords = (barRead(sc_regs::SWT_MON.index) >> 16);
-     isTimeout = std::chrono::steady_clock::now() > timeOut;
-   }
-   if(isTimeout){
+     return numWords >= 1;
+   };
+   auto start = std::chrono::steady_clock::now();
+   if (!Util::waitUntil(hasWords, start + std::chrono::milliseconds(msTimeOut))) {
+     if (readWords == 0) {
+       recordLatency(SwtTimeout, std::chrono::steady_clock::now() - start);
+     }
      break;
    }
+   recordLatency(SwtTimeout, std::chrono::steady_clock::now() - start);
+   recordLinkSuccess();
 
    for (int i = 0; i < (int)numWords; i++) {
      SwtWord tempWord;
@@ -150,29 +160,97 @@ std::vector<SwtWord> Swt::readMultiple(SwtWord::Size wordSize, unsigned int word
  return words;
 }
 
+void Swt::scReset()
+{
+  ScBase::scReset();
+  invalidateWriteCache();
+}
+
+void Swt::invalidateWriteCache()
+{
+  mLastHighValid = false;
+  mLastMedValid = false;
+}
+
+uint64_t Swt::getSkippedWrites() const
+{
+  return mSkippedWrites;
+}
+
 void Swt::write(const SwtWord& swtWord)
 {
   checkChannelSet();
 
-  // prep the swt word
+  // the cached values only hold for the link they were written on
+  if (mWriteCacheLinkId != mLink.rawLinkId) {
+    invalidateWriteCache();
+    mWriteCacheLinkId = mLink.rawLinkId;
+  }
+
+  // prep the swt word, skipping the HIGH and MED writes if the registers already hold the values
   if (swtWord.getSize() == SwtWord::Size::High) {
-    barWrite(sc_regs::SWT_WR_WORD_H.index, swtWord.getHigh());
+    if (mLastHighValid && mLastHigh == swtWord.getHigh()) {
+      mSkippedWrites++;
+      SwtWriteCacheStatistics::skippedWrites++;
+    } else {
+      barWrite(sc_regs::SWT_WR_WORD_H.index, swtWord.getHigh());
+      mLastHigh = swtWord.getHigh();
+      mLastHighValid = true;
+    }
   }
   if (swtWord.getSize() == SwtWord::Size::High || swtWord.getSize() == SwtWord::Size::Medium) {
-    barWrite(sc_regs::SWT_WR_WORD_M.index, swtWord.getMed());
+    if (mLastMedValid && mLastMed == swtWord.getMed()) {
+      mSkippedWrites++;
+      SwtWriteCacheStatistics::skippedWrites++;
+    } else {
+      barWrite(sc_regs::SWT_WR_WORD_M.index, swtWord.getMed());
+      mLastMed = swtWord.getMed();
+      mLastMedValid = true;
+    }
   }
   barWrite(sc_regs::SWT_WR_WORD_L.index, swtWord.getLow()); // The LOW bar write, triggers the write operation
 
   //return barRead(sc_regs::SWT_MON.index);
 }
 
+Swt::TimeOut Swt::getReadTimeout()
+{
+  if (readTimeoutSet) {
+    return readTimeout;
+  }
+  // Round the link's SWT timeout up to the ms resolution of the reads
+  return static_cast<TimeOut>(std::chrono::ceil<std::chrono::milliseconds>(getTimeout(SwtTimeout)).count());
+}
+
+Swt::PollData Swt::poll(PollData pollData)
+{
+  auto isDone = [&]() {
+    write(pollData.word);
+    pollData.reply = read(mSwtWordSize, getReadTimeout()).back();
+    return ((pollData.reply.getLow() & pollData.mask.getLow()) == (pollData.expected.getLow() & pollData.mask.getLow())) &&
+           ((pollData.reply.getMed() & pollData.mask.getMed()) == (pollData.expected.getMed() & pollData.mask.getMed())) &&
+           ((pollData.reply.getHigh() & pollData.mask.getHigh()) == (pollData.expected.getHigh() & pollData.mask.getHigh()));
+  };
+
+  if (!Util::pollUntil(isDone, pollData.interval, pollData.timeout, pollData.elapsed, [this]() { runOperationCallback(); })) {
+    std::stringstream ss;
+    ss << "Poll timeout after " << pollData.elapsed << " ms, last word=" << pollData.reply;
+    BOOST_THROW_EXCEPTION(SwtException() << ErrorInfo::Message(ss.str()));
+  }
+  return pollData;
+}
+
 std::vector<std::pair<Swt::Operation, Swt::Data>> Swt::executeSequence(std::vector<std::pair<Operation, Data>> sequence, bool lock, int lockTimeout)
 {
+  checkLinkUp();
 
   if (lock) {
     mLlaSession->start(lockTimeout);
   }
 
+  // The SWT registers may have been accessed by others since the last sequence
+  invalidateWriteCache();
+
   try {
     checkChannelSet();
   } catch (const SwtException& e) {
@@ -182,6 +260,7 @@ std::vector<std::pair<Swt::Operation, Swt::Data>> Swt::executeSequence(std::vect
   std::vector<std::pair<Operation, Data>> ret;
 
   for (const auto& it : sequence) {
+    runOperationCallback();
     Operation operation = it.first;
     Data data = it.second;
     try {
@@ -190,7 +269,7 @@ std::vector<std::pair<Swt::Operation, Swt::Data>> Swt::executeSequence(std::vect
         try {
           timeOut = boost::get<TimeOut>(data);
         } catch (...) { // no timeout was provided
-          data = readTimeout;
+          data = getReadTimeout();
           timeOut = boost::get<TimeOut>(data);
         }
         auto results = read(mSwtWordSize, timeOut);
@@ -201,13 +280,20 @@ std::vector<std::pair<Swt::Operation, Swt::Data>> Swt::executeSequence(std::vect
       } else if (operation == Operation::ReadMultiple) {
         int count;
         count = boost::get<int>(data);
-        auto results = readMultiple(mSwtWordSize, count, readTimeout);
+        auto results = readMultiple(mSwtWordSize, count, getReadTimeout());
         for (const auto& result : results) {
           ret.push_back({ operation, result });
         }
       } else if (operation == Operation::SetReadTimeout) {
         readTimeout = boost::get<TimeOut>(data);
+        readTimeoutSet = true;
         ret.push_back({ operation, readTimeout });
+      } else if (operation == Operation::WordSize) {
+        mSwtWordSize = boost::get<SwtWord::Size>(data);
+        ret.push_back({ operation, mSwtWordSize });
+      } else if (operation == Operation::Poll) {
+        auto result = poll(boost::get<PollData>(data));
+        ret.push_back({ operation, result });
       } else if (operation == Operation::Write) {
         SwtWord word = boost::get<SwtWord>(data);
         write(word);
@@ -237,6 +323,9 @@ std::vector<std::pair<Swt::Operation, Swt::Data>> Swt::executeSequence(std::vect
         meaningfulMessage = (boost::format("SWT_SEQUENCE WRITE data=%s serialId=%s link=%d, error='%s'") % boost::get<SwtWord>(data) % mLink.serialId % mLink.linkId % e.what()).str();
       } else if (operation == Operation::SCReset) {
         meaningfulMessage = (boost::format("SWT_SEQUENCE SC RESET serialId=%d link=%s, error='%s'") % mLink.serialId % mLink.linkId % e.what()).str();
+      } else if (operation == Operation::Poll) {
+        auto pollData = boost::get<PollData>(data);
+        meaningfulMessage = (boost::format("SWT_SEQUENCE POLL data=%s mask=%s expected=%s serialId=%s link=%d, error='%s'") % pollData.word % pollData.mask % pollData.expected % mLink.serialId % mLink.linkId % e.what()).str();
       } else if (operation == Operation::Wait) {
         meaningfulMessage = (boost::format("SWT_SEQUENCE WAIT waitTime=%d serialId=%s link=%d error='%s'") % boost::get<WaitTime>(data) % mLink.serialId % mLink.linkId % e.what()).str();
       } else {
@@ -250,16 +339,20 @@ std::vector<std::pair<Swt::Operation, Swt::Data>> Swt::executeSequence(std::vect
   }
 
   if (lock) {
-    mLlaSession->stop();
+    mLlaSession->stop(true);
   }
 
   return ret;
 }
 
 std::string Swt::writeSequence(std::vector<std::pair<Operation, Data>> sequence, bool lock, int lockTimeout)
+{
+  return formatSequenceOutput(executeSequence(sequence, lock, lockTimeout));
+}
+
+std::string Swt::formatSequenceOutput(const std::vector<std::pair<Operation, Data>>& out)
 {
   std::stringstream resultBuffer;
-  auto out = executeSequence(sequence, lock, lockTimeout);
   for (const auto& it : out) {
     Operation operation = it.first;
     Data data = it.second;
@@ -267,11 +360,13 @@ std::string Swt::writeSequence(std::vector<std::pair<Operation, Data>> sequence,
       resultBuffer << data << "\n";
     } else if (operation == Operation::ReadMultiple) {
       resultBuffer << data << "\n";
+    } else if (operation == Operation::Poll) {
+      resultBuffer << data << "\n"; // "[word],[elapsed]\n"
     } else if (operation == Operation::SetReadTimeout) {
       resultBuffer << std::dec << data << "\n";
     } else if (operation == Operation::Write) {
       resultBuffer << "0\n";
-    } else if (operation == Operation::SCReset) {
+    } else if (operation == Operation::SCReset || operation == Operation::WordSize) {
       /* DO NOTHING */
     } else if (operation == Operation::Wait) {
       resultBuffer << std::dec << data << "\n";
@@ -304,6 +399,10 @@ std::string Swt::SwtOperationToString(Swt::Operation op)
     return "wait";
   } else if (op == Swt::Operation::Lock) {
     return "lock";
+  } else if (op == Swt::Operation::WordSize) {
+    return "size";
+  } else if (op == Swt::Operation::Poll) {
+    return "poll";
   } else if (op == Swt::Operation::Error) {
     return "error";
   }
@@ -327,6 +426,10 @@ Swt::Operation Swt::StringToSwtOperation(std::string op)
     return Swt::Operation::Wait;
   } else if (op == "lock") {
     return Swt::Operation::Lock;
+  } else if (op == "size") {
+    return Swt::Operation::WordSize;
+  } else if (op == "poll") {
+    return Swt::Operation::Poll;
   } else if (op == "error") {
     return Swt::Operation::Error;
   }
@@ -334,5 +437,11 @@ Swt::Operation Swt::StringToSwtOperation(std::string op)
   BOOST_THROW_EXCEPTION(SwtException() << ErrorInfo::Message("Cannot convert operation to SWT string " + op));
 }
 
+std::ostream& operator<<(std::ostream& output, const Swt::PollData& pollData)
+{
+  output << pollData.reply << "," << std::dec << pollData.elapsed;
+  return output;
+}
+
 } // namespace alf
 } // namespace o2
@@ -262,6 +262,17 @@ struct SwtDataToPython {
       return bp::incref(bp::object(data).ptr());
     }
 
+    auto operator()(Swt::PollData data) const
+    {
+      bp::tuple ret = bp::make_tuple(data.reply.getLow(), data.elapsed);
+      return bp::incref(bp::object(ret).ptr());
+    }
+
+    auto operator()(SwtWord::Size data) const
+    {
+      return bp::incref(bp::object(static_cast<int>(data)).ptr());
+    }
+
     auto operator()(boost::blank) const
     {
       std::string data = "";
@@ -0,0 +1,152 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file ThreadPool.h
+/// \brief Definition of a fixed-size worker pool for the ALF server
+
+#ifndef O2_ALF_SRC_THREADPOOL_H_
+#define O2_ALF_SRC_THREADPOOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace o2
+{
+namespace alf
+{
+
+/// Fixed-size pool of worker threads. Tasks submitted with the same key run one at a time and in submission order,
+/// while idle workers pick up the pending tasks of any other key.
+class ThreadPool
+{
+ public:
+  ThreadPool(size_t numThreads)
+  {
+    for (size_t i = 0; i < numThreads; i++) {
+      mThreads.emplace_back([this] { work(); });
+    }
+  }
+
+  ~ThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStop = true;
+    }
+    mCondition.notify_all();
+    for (auto& thread : mThreads) {
+      thread.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /// Submits a task to be ordered after the other tasks of the same key
+  /// \param key The key ordering the task, e.g. a link
+  /// \return A future for the result of the task
+  template <typename Function>
+  auto submit(uint64_t key, Function function) -> std::future<decltype(function())>
+  {
+    auto task = std::make_shared<std::packaged_task<decltype(function())()>>(std::move(function));
+    auto future = task->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      Strand& strand = mStrands[key];
+      strand.tasks.emplace_back([task] { (*task)(); });
+      if (!strand.scheduled) {
+        strand.scheduled = true;
+        mReady.push_back(key);
+      }
+    }
+    mCondition.notify_one();
+    return future;
+  }
+
+  /// Submits a task with no ordering constraint
+  /// \return A future for the result of the task
+  template <typename Function>
+  auto submit(Function function) -> std::future<decltype(function())>
+  {
+    uint64_t key;
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      key = kUnorderedKeys | mNextUnorderedKey++;
+    }
+    return submit(key, std::move(function));
+  }
+
+  size_t size() const
+  {
+    return mThreads.size();
+  }
+
+ private:
+  /// Tasks of one key; scheduled while the key is in the ready queue or being run
+  struct Strand {
+    std::deque<std::function<void()>> tasks;
+    bool scheduled = false;
+  };
+
+  void work()
+  {
+    while (true) {
+      uint64_t key;
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [this] { return mStop || !mReady.empty(); });
+        if (mReady.empty()) {
+          return;
+        }
+        key = mReady.front();
+        mReady.pop_front();
+        task = std::move(mStrands[key].tasks.front());
+        mStrands[key].tasks.pop_front();
+      }
+
+      task();
+
+      {
+        std::lock_guard<std::mutex> lock(mMutex);
+        Strand& strand = mStrands[key];
+        if (strand.tasks.empty()) {
+          mStrands.erase(key);
+        } else {
+          mReady.push_back(key);
+          mCondition.notify_one();
+        }
+      }
+    }
+  }
+
+  static constexpr uint64_t kUnorderedKeys = 1ull << 63;
+
+  std::vector<std::thread> mThreads;
+  std::map<uint64_t, Strand> mStrands;
+  std::deque<uint64_t> mReady;
+  uint64_t mNextUnorderedKey = 0;
+  std::mutex mMutex;
+  std::condition_variable mCondition;
+  bool mStop = false;
+};
+
+} // namespace alf
+} // namespace o2
+
+#endif // O2_ALF_SRC_THREADPOOL_H_
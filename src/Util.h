@@ -21,6 +21,10 @@
 
 #include <boost/format.hpp>
 #include <boost/algorithm/string.hpp>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <thread>
 
 #include "Alf/Common.h"
 #include "Logger.h"
@@ -66,6 +70,62 @@ inline std::vector<std::string> split(const std::string& input, std::string sepa
   return output;
 }
 
+/// Evaluates a condition every interval ms, until it holds or the timeout expires
+/// \param condition Callable returning true once the polled state is reached
+/// \param interval Time to sleep between attempts in ms
+/// \param timeout Maximum time to poll for in ms
+/// \param elapsed Set to the time spent polling in ms
+/// \param checkpoint Optional callable run every 10 ms of sleep at most, e.g. to abort the poll past a deadline
+/// \return true if the condition was met before the timeout
+template <typename Condition>
+bool pollUntil(Condition condition, int interval, int timeout, int& elapsed, std::function<void()> checkpoint = nullptr)
+{
+  constexpr auto slice = std::chrono::milliseconds(10);
+  auto start = std::chrono::steady_clock::now();
+  auto endTime = start + std::chrono::milliseconds(timeout);
+  bool met = condition();
+  while (!met && std::chrono::steady_clock::now() < endTime) {
+    auto wakeUp = std::chrono::steady_clock::now() + std::chrono::milliseconds(interval);
+    for (auto now = std::chrono::steady_clock::now(); now < wakeUp; now = std::chrono::steady_clock::now()) {
+      std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(slice, wakeUp - now));
+      if (checkpoint) {
+        checkpoint();
+      }
+    }
+    met = condition();
+  }
+  elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+  return met;
+}
+
+/// Waits for a hardware condition without spinning on the CPU: the condition is first re-evaluated after yielding,
+/// then after sleeps growing from 10 us up to 1 ms, so that waiting threads leave the CPU to the other links
+/// \param condition Callable returning true once the awaited state is reached
+/// \param deadline Time after which the condition is no longer evaluated
+/// \return true if the condition was met before the deadline
+template <typename Condition>
+bool waitUntil(Condition condition, std::chrono::steady_clock::time_point deadline)
+{
+  constexpr int yieldAttempts = 16;
+  constexpr auto maxSleep = std::chrono::microseconds(1000);
+  auto sleep = std::chrono::microseconds(10);
+  for (int attempt = 0;; attempt++) {
+    auto now = std::chrono::steady_clock::now();
+    if (now >= deadline) {
+      return false;
+    }
+    if (condition()) {
+      return true;
+    }
+    if (attempt < yieldAttempts) {
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(sleep, deadline - now));
+      sleep = std::min(sleep * 2, maxSleep);
+    }
+  }
+}
+
 inline size_t strlenMax(char* str, size_t max)
 {
   for (size_t i = 0; i < max; i++) {